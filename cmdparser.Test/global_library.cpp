@@ -0,0 +1,15 @@
+/*
+  This file is part of the C++ CmdParser utility.
+  Copyright (c) 2015 - 2016 Florian Rappl
+*/
+
+#include "../cmdparser.hpp"
+
+// A shared library defining a global option of its own, see "Discover global options of a library".
+CMDPARSER_GLOBAL(int, library_batch, "B", "library-batch", 2, "The batch size of the library.");
+CMDPARSER_GLOBAL_LIBRARY(cmdparser_test_library)
+
+int cmdparser_test_library_batch()
+{
+	return cmdparser_library_batch;
+}
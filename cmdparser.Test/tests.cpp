@@ -5,10 +5,21 @@
 
 #include "catch.hpp"
 #include <sstream>
+#include <chrono>
+#include <fstream>
+#include <cstdio>
+#include <condition_variable>
 #include "../cmdparser.hpp"
 
 using namespace cli;
 
+CMDPARSER_GLOBAL(int, test_threads, "T", "test-threads", 4, "The number of threads.");
+CMDPARSER_GLOBAL(std::string, test_model, "M", "test-model", "small", "The model.");
+
+// Defined in the shared library built from global_library.cpp.
+GlobalOptions cmdparser_test_library();
+int cmdparser_test_library_batch();
+
 TEST_CASE( "Parse help", "[help]" ) {
 	std::stringstream output { };
 	std::stringstream errors { };
@@ -428,3 +439,1659 @@ TEST_CASE( "Parse non-required integer with get if", "[n]" ) {
 		REQUIRE(ret == 42);
 	}
 }
+
+TEST_CASE( "Complete option names", "[completion]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[3] = {
+		"myapp",
+		"--__complete",
+		"--ver"
+	};
+
+	Parser parser(3, args);
+	parser.set_optional<bool>("v", "verbose", false);
+	parser.set_optional<bool>("V", "version", false);
+	parser.set_required<int>("n", "number");
+
+	REQUIRE(parser.run(output, errors) == false);
+	REQUIRE(output.str().empty());
+	REQUIRE(errors.str().find("--__complete") != std::string::npos);
+
+	errors.str("");
+	parser.enable_completion();
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(output.str() == "--verbose\n--version\n");
+	REQUIRE(errors.str().empty());
+
+	const auto all = parser.complete("-");
+
+	REQUIRE(all.size() == 8u);
+	REQUIRE(parser.complete("-n") == std::vector<std::string> { "-n" });
+	REQUIRE(parser.complete("file").empty());
+}
+
+TEST_CASE( "Generate completion scripts", "[completion]" ) {
+	const char* args[1] = {
+		"/usr/bin/my-app"
+	};
+
+	Parser parser(1, args);
+	parser.set_optional<bool>("v", "verbose", false, "Print what's going on.");
+
+	const auto bash = parser.completion_script(CompletionShell::Bash);
+	const auto zsh = parser.completion_script(CompletionShell::Zsh);
+	const auto fish = parser.completion_script(CompletionShell::Fish);
+
+	REQUIRE(bash.find("complete -o default -F _my_app_complete my-app") != std::string::npos);
+	REQUIRE(bash.find("--verbose") != std::string::npos);
+	REQUIRE(zsh.find("#compdef my-app") != std::string::npos);
+	REQUIRE(zsh.find("'(-v --verbose)'{-v,--verbose}'[Print what'\\''s going on.]'") != std::string::npos);
+	REQUIRE(fish.find("complete -c my-app -s v -l verbose -d 'Print what\\'s going on.'") != std::string::npos);
+	REQUIRE(fish.find("-l help") != std::string::npos);
+}
+
+TEST_CASE( "Parse abbreviated long option", "[abbreviation]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[4] = {
+		"myapp",
+		"--verb",
+		"--num",
+		"42"
+	};
+
+	Parser parser(4, args);
+	parser.enable_abbreviations();
+	parser.set_optional<bool>("v", "verbose", false);
+	parser.set_optional<bool>("V", "version", false);
+	parser.set_required<int>("n", "number");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+	REQUIRE(parser.get<bool>("v") == true);
+	REQUIRE(parser.get<bool>("V") == false);
+	REQUIRE(parser.get<int>("n") == 42);
+}
+
+TEST_CASE( "Parse ambiguous abbreviated long option", "[abbreviation]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[2] = {
+		"myapp",
+		"--ver"
+	};
+
+	SECTION("abbreviations enabled") {
+		Parser parser(2, args);
+		parser.enable_abbreviations();
+		parser.set_optional<bool>("v", "verbose", false);
+		parser.set_optional<bool>("V", "version", false);
+		parser.set_default<std::string>(false);
+		const auto value = parser.run(output, errors);
+
+		REQUIRE(value == false);
+		REQUIRE(errors.str().find("Ambiguous parameter '--ver', could be '--verbose' '--version'") != std::string::npos);
+	}
+
+	SECTION("abbreviations disabled") {
+		Parser parser(2, args);
+		parser.set_optional<bool>("v", "verbose", false);
+		const auto value = parser.run(output, errors);
+
+		REQUIRE(value == false);
+		REQUIRE(errors.str().find("Invalid parameter '--ver'") != std::string::npos);
+	}
+}
+
+TEST_CASE( "Suggest option for mistyped parameter", "[suggestion]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[2] = {
+		"myapp",
+		"--verbsoe"
+	};
+
+	Parser parser(2, args);
+	parser.set_optional<bool>("v", "verbose", false);
+	parser.set_optional<bool>("V", "version", false);
+	parser.set_optional<std::string>("o", "output", "data");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(errors.str().find("Invalid parameter '--verbsoe'\nDid you mean '--verbose'?") != std::string::npos);
+}
+
+TEST_CASE( "No suggestion for unrelated parameter", "[suggestion]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[2] = {
+		"myapp",
+		"--frobnicate"
+	};
+
+	Parser parser(2, args);
+	parser.set_optional<bool>("v", "verbose", false);
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(errors.str().find("Did you mean") == std::string::npos);
+}
+
+TEST_CASE( "Report memory usage per option", "[memory]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[5] = {
+		"myapp",
+		"-v",
+		"1",
+		"2",
+		"3"
+	};
+
+	Parser parser(5, args);
+	parser.set_optional<bool>("a", "all", false, "Shared description.");
+	parser.set_optional<bool>("b", "both", false, "Shared description.");
+	parser.set_required<std::vector<int>>("v", "values");
+	const auto before = parser.memory_usage("v");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+	REQUIRE(parser.memory_usage("a") >= sizeof(bool) + std::string("-a--allShared description.").size());
+	REQUIRE(parser.memory_usage("v") >= before + 3 * sizeof(int));
+	REQUIRE(parser.memory_usage() > parser.memory_usage("v"));
+	REQUIRE_THROWS(parser.memory_usage("x"));
+}
+
+TEST_CASE( "Static usage matches generated usage", "[help] [static]" ) {
+	std::stringstream generated { };
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[2] = {
+		"myapp",
+		"--help"
+	};
+
+	static const char usage[] =
+		CMDPARSER_USAGE_GENERAL("My application")
+		CMDPARSER_USAGE_HELP
+		CMDPARSER_USAGE_REQUIRED("n", "number", "The number.")
+		CMDPARSER_USAGE_OPTIONAL("o", "output", "data", "The output.")
+		CMDPARSER_USAGE_RUNTIME("t", "threads", "Number of threads.");
+
+	const auto configure = [](Parser& parser) {
+		parser.set_required<int>("n", "number", "The number.");
+		parser.set_optional<std::string>("o", "output", "data", "The output.");
+		parser.set_optional<int>("t", "threads", 4, "Number of threads.");
+	};
+
+	Parser dynamic(2, args, "My application");
+	configure(dynamic);
+	dynamic.run(generated, errors);
+
+	Parser parser(2, args, "My application");
+	configure(parser);
+	parser.set_static_usage(usage);
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(output.str() == generated.str());
+	REQUIRE(output.str().find("Default:\t'4'") != std::string::npos);
+	REQUIRE(parser.check_static_usage(errors) == true);
+
+	parser.set_optional<bool>("v", "verbose", false);
+	REQUIRE(parser.check_static_usage(errors) == false);
+	REQUIRE(errors.str() == "ERROR: The static usage text has no entry for 'v'.\n");
+}
+
+TEST_CASE( "Lazy parsing converts on first access", "[lazy]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[6] = {
+		"myapp",
+		"-n",
+		"42",
+		"-c",
+		"-x",
+		"abc"
+	};
+
+	int calls = 0;
+	int validations = 0;
+	Parser parser(6, args);
+	parser.enable_lazy_parsing();
+	parser.set_required<int>("n", "number", "", [&](const int&, std::ostream&, std::ostream&) {
+		++validations;
+		return true;
+	});
+	parser.set_callback("c", "count", std::function<int(CallbackArgs&)>([&](CallbackArgs&) {
+		return ++calls;
+	}));
+	parser.set_optional<double>("x", "x-value", 0.0);
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+	REQUIRE(calls == 0);
+	REQUIRE(validations == 0);
+
+	REQUIRE(parser.get<int>("n") == 42);
+	REQUIRE(parser.get<int>("n") == 42);
+	REQUIRE(validations == 1);
+
+	REQUIRE(parser.get<int>("c") == 1);
+	REQUIRE(calls == 1);
+
+	REQUIRE_THROWS_WITH(parser.get<double>("x"), Catch::Contains("The parameter 'x' has invalid arguments"));
+	REQUIRE_THROWS_WITH(parser.get<double>("x"), Catch::Contains("The parameter 'x' has invalid arguments"));
+
+	const char* valid[3] = { "myapp", "-n", "1" };
+	parser.init(3, valid);
+	REQUIRE(parser.run(output, errors) == true);
+	REQUIRE(parser.get<double>("x") == 0.0);
+}
+
+TEST_CASE( "Lazy parsing converts once for concurrent readers", "[lazy] [parallel]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[5] = { "myapp", "-c", "-l", "1", "2" };
+	std::atomic<int> calls(0);
+	Parser parser(5, args);
+	parser.enable_lazy_parsing();
+	parser.set_callback("c", "count", std::function<int(CallbackArgs&)>([&](CallbackArgs&) {
+		return ++calls;
+	}));
+	parser.set_optional<std::vector<int>>("l", "list", std::vector<int>());
+	REQUIRE(parser.run(output, errors) == true);
+
+	std::atomic<bool> consistent(true);
+	std::vector<std::thread> readers { };
+
+	for (int i = 0; i < 8; ++i)
+	{
+		readers.emplace_back([&]() {
+			if (parser.get<int>("c") != 1 || parser.get_ref<std::vector<int>>("l").size() != 2u)
+				consistent = false;
+		});
+	}
+
+	for (auto& reader : readers)
+		reader.join();
+
+	REQUIRE(consistent);
+	REQUIRE(calls == 1);
+}
+
+TEST_CASE( "Lazy parsing still checks required options", "[lazy]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[1] = {
+		"myapp"
+	};
+
+	Parser parser(1, args);
+	parser.enable_lazy_parsing();
+	parser.set_required<int>("n", "number");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+}
+
+TEST_CASE( "Terminating option skips remaining arguments", "[dominant] [terminating]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	std::vector<const char*> args { "myapp", "-n", "42", "--version" };
+	args.resize(100000, "-unknown");
+
+	int validations = 0;
+	Parser parser(static_cast<int>(args.size()), args.data());
+	parser.set_required<int>("n", "number", "", [&](const int&, std::ostream&, std::ostream&) {
+		++validations;
+		return true;
+	});
+	parser.set_required<std::string>("o", "output");
+	parser.set_callback("V", "version", std::function<bool(CallbackArgs&)>([](CallbackArgs& args) {
+		args.output << "1.0";
+		return true;
+	}), "", true);
+	parser.set_terminating("V");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(output.str() == "1.0");
+	REQUIRE(errors.str().empty());
+	REQUIRE(validations == 0);
+}
+
+TEST_CASE( "Check for arguments before declaring options", "[presence]" ) {
+	const char* args[5] = {
+		"myapp",
+		"--profile",
+		"fast",
+		"-v",
+		"--help"
+	};
+
+	Parser parser(5, args);
+
+	REQUIRE(parser.doesArgumentExist("v", "--verbose") == true);
+	REQUIRE(parser.doesArgumentExist("p", "--profile") == true);
+	REQUIRE(parser.doesArgumentExist("x", "--extra") == false);
+	REQUIRE(parser.doesArgumentExist("ast", "--fast") == false);
+	REQUIRE(parser.doesArgumentExist("", "") == false);
+	REQUIRE(parser.doesHelpExist() == true);
+
+	Parser fresh(5, args);
+	std::atomic<bool> consistent(true);
+	std::vector<std::thread> queries { };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		queries.emplace_back([&]() {
+			if (!fresh.doesHelpExist() || fresh.doesArgumentExist("x", "--extra"))
+				consistent = false;
+		});
+	}
+
+	for (auto& query : queries)
+		query.join();
+
+	REQUIRE(consistent);
+}
+
+TEST_CASE( "Access values without copying", "[get_ref] [take]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[5] = {
+		"myapp",
+		"-v",
+		"0.5",
+		"1.5",
+		"2.5"
+	};
+
+	Parser parser(5, args);
+	parser.set_required<std::vector<double>>("v", "values");
+	parser.set_optional<std::string>("o", "output", std::string(64, 'o'));
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+
+	const auto& values = parser.get_ref<std::vector<double>>("v");
+	REQUIRE(&values == &parser.get_ref<std::vector<double>>("v"));
+	REQUIRE(values.size() == 3u);
+
+	const auto data = values.data();
+	const auto taken = parser.take<std::vector<double>>("v");
+	REQUIRE(taken.data() == data);
+	REQUIRE(parser.get<std::vector<double>>("v").empty());
+
+	REQUIRE(parser.get_ref<std::string>("o") == std::string(64, 'o'));
+	REQUIRE_THROWS(parser.get_ref<int>("o"));
+}
+
+TEST_CASE( "Reparse values that were taken", "[reparse]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::vector<int>>("l", "list", std::vector<int>());
+
+	const char* args[4] = { "myapp", "-l", "1", "2" };
+	REQUIRE(parser.reparse(4, args, output, errors) == true);
+	REQUIRE(parser.take<std::vector<int>>("l") == std::vector<int>({ 1, 2 }));
+	REQUIRE(parser.reparse(4, args, output, errors) == true);
+	REQUIRE(parser.get<std::vector<int>>("l") == std::vector<int>({ 1, 2 }));
+}
+
+TEST_CASE( "Parse list of strings", "[strings] [available]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[6] = {
+		"myapp",
+		"-f",
+		"/a/very/long/path/that/does/not/fit/into/a/small/string",
+		"b",
+		"-o",
+		"/another/very/long/path/that/does/not/fit/into/a/small/string"
+	};
+
+	Parser parser(6, args);
+	parser.set_required<std::vector<std::string>>("f", "files");
+	parser.set_required<std::string>("o", "output");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+
+	const auto& files = parser.get_ref<std::vector<std::string>>("f");
+
+	REQUIRE(files.size() == 2u);
+	REQUIRE(files[0] == args[2]);
+	REQUIRE(files[1] == "b");
+	REQUIRE(parser.get<std::string>("o") == args[5]);
+}
+
+TEST_CASE( "Parse command line string", "[line]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::string>("o", "output", "");
+	parser.set_optional<std::vector<std::string>>("f", "files", { });
+	parser.set_optional<int>("n", "number", 0);
+	const auto value = parser.run_line("  --files 'a b'   \"c \\\"d\\\" \\e\" f\\ g '' x\"y\"'z'\\\n -o /a/rather/long/path/with/more/than/thirty-two/characters\t-n 42", output, errors);
+
+	REQUIRE(value == true);
+
+	const auto& files = parser.get_ref<std::vector<std::string>>("f");
+
+	REQUIRE(files == std::vector<std::string> { "a b", "c \"d\" \\e", "f g", "", "xyz" });
+	REQUIRE(parser.get<std::string>("o") == "/a/rather/long/path/with/more/than/thirty-two/characters");
+	REQUIRE(parser.get<int>("n") == 42);
+}
+
+TEST_CASE( "Parse command line string with unterminated quote", "[line]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::string>("o", "output", "");
+
+	REQUIRE(parser.run_line("-o 'unterminated", output, errors) == false);
+	REQUIRE(errors.str().find("unterminated quote") != std::string::npos);
+	REQUIRE(parser.run_line("-o escaped\\", output, errors) == false);
+}
+
+TEST_CASE( "Keep the previous arguments after an unterminated quote", "[line]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::string>("o", "output", "");
+
+	REQUIRE(parser.run_line("-o first", output, errors) == true);
+	REQUIRE(parser.run_line("-o 'a rather long unterminated argument that needs new storage", output, errors) == false);
+	REQUIRE(parser.run(output, errors) == true);
+	REQUIRE(parser.get<std::string>("o") == "first");
+}
+
+TEST_CASE( "Forward unknown options and remainder", "[forwarding]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[10] = {
+		"myapp",
+		"-n",
+		"2",
+		"--child-flag",
+		"value",
+		"-v",
+		"--",
+		"child",
+		"-n",
+		"3"
+	};
+
+	Parser parser(10, args);
+	parser.enable_forwarding();
+	parser.set_required<int>("n", "number");
+	parser.set_optional<bool>("v", "verbose", false);
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+	REQUIRE(parser.get<int>("n") == 2);
+	REQUIRE(parser.get<bool>("v") == true);
+	REQUIRE(parser.forwarded_count() == 5u);
+
+	const auto forwarded = parser.forwarded_argv("child-app");
+
+	REQUIRE(std::string(forwarded[0]) == "child-app");
+	REQUIRE(std::string(forwarded[1]) == "--child-flag");
+	REQUIRE(std::string(forwarded[2]) == "value");
+	REQUIRE(std::string(forwarded[3]) == "child");
+	REQUIRE(std::string(forwarded[4]) == "-n");
+	REQUIRE(std::string(forwarded[5]) == "3");
+	REQUIRE(forwarded[6] == nullptr);
+}
+
+TEST_CASE( "Copy the arguments unless borrowed", "[arguments] [forwarding]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[4] = {
+		"myapp",
+		"-n",
+		"2",
+		"--child-flag"
+	};
+
+	std::vector<std::string> temporary { "myapp", "-n", "5" };
+	std::vector<const char*> pointers { };
+
+	for (const auto& argument : temporary)
+		pointers.push_back(argument.c_str());
+
+	Parser copying(static_cast<int>(pointers.size()), pointers.data());
+	copying.set_required<int>("n", "number");
+	temporary.assign(3, std::string(32, 'x'));
+
+	REQUIRE(copying.run(output, errors) == true);
+	REQUIRE(copying.get<int>("n") == 5);
+
+	Parser borrowing;
+	borrowing.borrow(4, args);
+	borrowing.enable_forwarding();
+	borrowing.set_required<int>("n", "number");
+
+	REQUIRE(borrowing.run(output, errors) == true);
+	REQUIRE(borrowing.has_help() == true);
+	REQUIRE(borrowing.get<int>("n") == 2);
+	REQUIRE(borrowing.forwarded_count() == 1u);
+	REQUIRE(borrowing.forwarded_argv("child-app")[1] == args[3]);
+}
+
+TEST_CASE( "Keep negative values when forwarding", "[forwarding]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.enable_forwarding();
+	parser.set_optional<int>("n", "number", 0);
+	parser.set_optional<bool>("v", "verbose", false);
+
+	REQUIRE(parser.run_line("-n -5 -v --child -3", output, errors) == true);
+	REQUIRE(parser.get<int>("n") == -5);
+	REQUIRE(parser.get<bool>("v") == true);
+	REQUIRE(parser.forwarded_count() == 2u);
+	REQUIRE(std::string(parser.forwarded_argv("child")[1]) == "--child");
+	REQUIRE(std::string(parser.forwarded_argv("child")[2]) == "-3");
+}
+
+TEST_CASE( "Parse values after double dash", "[forwarding]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[4] = {
+		"myapp",
+		"-o",
+		"--",
+		"-file"
+	};
+
+	Parser parser(4, args);
+	parser.set_required<std::string>("o", "output");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+	REQUIRE(parser.get<std::string>("o") == "-file");
+	REQUIRE(parser.forwarded_count() == 0u);
+}
+
+TEST_CASE( "Stream list elements to a consumer", "[stream]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[7] = {
+		"myapp",
+		"-f",
+		"a.txt",
+		"b.txt",
+		"-n",
+		"2",
+		"--unknown"
+	};
+
+	std::vector<std::string> received { };
+	Parser parser(7, args);
+	parser.set_stream<std::string>("f", "files", [&](std::string&& file, std::ostream&, std::ostream&) {
+		received.push_back(std::move(file));
+		return true;
+	});
+	parser.set_required<int>("n", "number");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(received == std::vector<std::string> { "a.txt", "b.txt" });
+}
+
+TEST_CASE( "Stream list elements with invalid element", "[stream]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[5] = {
+		"myapp",
+		"-v",
+		"1",
+		"x",
+		"3"
+	};
+
+	int sum = 0;
+	Parser parser(5, args);
+	parser.set_stream<int>("v", "values", [&](int&& value, std::ostream&, std::ostream&) {
+		sum += value;
+		return true;
+	});
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(sum == 1);
+	REQUIRE(errors.str().find("ERROR: Parsing 'v' command arguments: x") != std::string::npos);
+}
+
+TEST_CASE( "Validate independent options in parallel", "[validation] [parallel]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[7] = {
+		"myapp",
+		"-a",
+		"1",
+		"-b",
+		"2",
+		"-c",
+		"3"
+	};
+
+	const auto slow = [](const int& value, std::ostream& output, std::ostream&) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50 * (4 - value)));
+		output << value;
+		return true;
+	};
+
+	Parser parser(7, args);
+	parser.enable_parallel_validation(3);
+	parser.set_required<int>("a", "alpha", "", slow);
+	parser.set_required<int>("b", "beta", "", slow);
+	parser.set_required<int>("c", "gamma", "", slow);
+	parser.set_independent("a");
+	parser.set_independent("c");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == true);
+	REQUIRE(output.str() == "123");
+	REQUIRE(parser.get<int>("b") == 2);
+}
+
+TEST_CASE( "Report first failing parallel validation in declaration order", "[validation] [parallel]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[5] = {
+		"myapp",
+		"-a",
+		"1",
+		"-b",
+		"2"
+	};
+
+	const auto fail = [](const int& value, std::ostream&, std::ostream& error) {
+		error << "failed " << value << std::endl;
+		return false;
+	};
+
+	Parser parser(5, args);
+	parser.enable_parallel_validation();
+	parser.set_required<int>("a", "alpha", "", fail);
+	parser.set_required<int>("b", "beta", "", fail);
+	parser.set_independent("a");
+	parser.set_independent("b");
+	const auto value = parser.run(output, errors);
+
+	REQUIRE(value == false);
+	REQUIRE(errors.str().find("failed 1\nERROR: The parameter 'a' has invalid arguments.") == 0);
+	REQUIRE(errors.str().find("failed 2") == std::string::npos);
+}
+
+TEST_CASE( "Validate path arguments", "[path]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* directory = std::getenv("TMPDIR");
+	const std::string file = std::string(directory != nullptr ? directory : "/tmp") + "/cmdparser_test_file.txt";
+	std::ofstream(file) << "test";
+
+	const auto run = [&](const char* out, bool missing) {
+		std::vector<const char*> args { "myapp", "-d", ".", "-o", out, "-i" };
+		args.resize(args.size() + 100, file.c_str());
+
+		if (missing)
+			args.push_back("missing.txt");
+
+		Parser parser(static_cast<int>(args.size()), args.data());
+		parser.set_required<Directory>("d", "directory");
+		parser.set_required<OutputPath>("o", "output");
+		parser.set_required<std::vector<ReadablePath>>("i", "inputs");
+		const auto value = parser.run(output, errors);
+
+		if (value)
+		{
+			REQUIRE(parser.get<OutputPath>("o").value == "out.txt");
+			REQUIRE(parser.get_ref<std::vector<ReadablePath>>("i").size() == 100u);
+		}
+
+		return value;
+	};
+
+	SECTION("all paths are checked") {
+		REQUIRE(run("missing/out.txt", true) == false);
+		REQUIRE(errors.str().find("ERROR: The directory of the path 'missing/out.txt' is not writable.") == 0);
+	}
+
+	SECTION("each missing path is reported") {
+		REQUIRE(run("out.txt", true) == false);
+		REQUIRE(errors.str().find("ERROR: The path 'missing.txt' does not exist.") == 0);
+		REQUIRE(errors.str().find(file) == std::string::npos);
+	}
+
+	SECTION("valid paths") {
+		REQUIRE(run("out.txt", false) == true);
+	}
+
+	std::remove(file.c_str());
+}
+
+TEST_CASE( "Validate independent path lists in parallel", "[path] [parallel]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* directory = std::getenv("TMPDIR");
+	const std::string file = std::string(directory != nullptr ? directory : "/tmp") + "/cmdparser_test_lists.txt";
+	std::ofstream(file) << "test";
+
+	const std::vector<std::string> options { "-a", "-b", "-c", "-d", "-e", "-f", "-g", "-i" };
+	std::vector<const char*> args { "myapp" };
+
+	for (const auto& option : options)
+	{
+		args.push_back(option.c_str());
+		args.resize(args.size() + 50, file.c_str());
+	}
+
+	args.push_back("missing.txt");
+
+	Parser parser(static_cast<int>(args.size()), args.data());
+	parser.enable_parallel_validation(static_cast<unsigned int>(options.size()));
+
+	for (const auto& option : options)
+	{
+		parser.set_required<std::vector<ReadablePath>>(option.substr(1), "list-" + option.substr(1));
+		parser.set_independent(option.substr(1));
+	}
+
+	REQUIRE(parser.run(output, errors) == false);
+	REQUIRE(errors.str().find("ERROR: The path 'missing.txt' does not exist.\nERROR: The parameter 'i' has invalid arguments.") == 0);
+
+	std::remove(file.c_str());
+}
+
+TEST_CASE( "Run independent callbacks asynchronously", "[callback] [async]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[3] = {
+		"myapp",
+		"-s",
+		"-d"
+	};
+
+	// Each callback waits until the other one has started as well, which only happens
+	// when they run concurrently. The timeout merely keeps a sequential run from hanging.
+	std::mutex mutex { };
+	std::condition_variable started { };
+	size_t running = 0;
+	std::atomic<bool> overlapped(true);
+
+	const auto fetch = [&](const std::string& result) {
+		return std::function<std::string(CallbackArgs&)>([&, result](CallbackArgs& args) {
+			std::unique_lock<std::mutex> lock(mutex);
+			++running;
+			started.notify_all();
+
+			if (!started.wait_for(lock, std::chrono::seconds(10), [&] { return running == 2; }))
+				overlapped = false;
+
+			args.output << result;
+			return result;
+		});
+	};
+
+	Parser parser(3, args);
+	parser.set_callback("s", "secret", fetch("secret"));
+	parser.set_callback("d", "device", fetch("device"));
+	parser.set_independent("s");
+	parser.set_independent("d");
+	parser.enable_parallel_validation(2);
+
+	auto result = parser.run_async(output, errors);
+	const auto value = result.get();
+
+	REQUIRE(value == true);
+	REQUIRE(overlapped == true);
+	REQUIRE(output.str() == "secretdevice");
+	REQUIRE(parser.get<std::string>("s") == "secret");
+	REQUIRE(parser.get<std::string>("d") == "device");
+}
+
+TEST_CASE( "Reuse parser for several command lines", "[line] [reuse]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::string>("o", "output", "data");
+	parser.set_optional<bool>("v", "verbose", false);
+
+	REQUIRE(parser.run_line("-o first -v", output, errors) == true);
+	REQUIRE(parser.get<std::string>("o") == "first");
+	REQUIRE(parser.get<bool>("v") == true);
+
+	REQUIRE(parser.run_line("-v", output, errors) == true);
+	REQUIRE(parser.get<std::string>("o") == "data");
+	REQUIRE(parser.get<bool>("v") == true);
+
+	REQUIRE(parser.run_line("", output, errors) == true);
+	REQUIRE(parser.get<bool>("v") == false);
+}
+
+TEST_CASE( "Reset callback results between command lines", "[line] [reuse] [callback]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_callback("c", "count", std::function<int(CallbackArgs&)>([](CallbackArgs& args) {
+		return static_cast<int>(args.arguments.front().size());
+	}));
+
+	REQUIRE(parser.run_line("-c abc", output, errors) == true);
+	REQUIRE(parser.get<int>("c") == 3);
+
+	REQUIRE(parser.run_line("", output, errors) == true);
+	REQUIRE(parser.get<int>("c") == 0);
+}
+
+TEST_CASE( "Cache results of pure validators", "[validation] [cache]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	int validations = 0;
+	Parser parser;
+	parser.set_optional<std::string>("m", "model", "", "", [&](const std::string& model, std::ostream&, std::ostream& error) {
+		++validations;
+		error << "checked " << model << std::endl;
+		return model != "unknown";
+	});
+	parser.set_pure("m");
+	parser.set_optional<std::string>("t", "task", "", "", [](const std::string& task, std::ostream&, std::ostream&) {
+		return task != "x";
+	});
+	parser.set_pure("t");
+
+	SECTION("repeated values are validated once") {
+		parser.enable_validation_cache();
+
+		REQUIRE(parser.run_line("-m small", output, errors) == true);
+		REQUIRE(parser.run_line("-m small", output, errors) == true);
+		REQUIRE(parser.run_line("-m unknown", output, errors) == false);
+		REQUIRE(parser.run_line("-m unknown", output, errors) == false);
+		REQUIRE(validations == 2);
+		REQUIRE(parser.validation_cache_statistics().hits == 2u);
+		REQUIRE(parser.validation_cache_statistics().misses == 2u);
+		REQUIRE(errors.str().find("checked small\nchecked small\n") == 0);
+	}
+
+	SECTION("expired entries are validated again") {
+		parser.enable_validation_cache(16, std::chrono::seconds(0));
+
+		REQUIRE(parser.run_line("-m small", output, errors) == true);
+		REQUIRE(parser.run_line("-m small", output, errors) == true);
+		REQUIRE(validations == 2);
+		REQUIRE(parser.validation_cache_statistics().hits == 0u);
+	}
+
+	SECTION("least recently used entries are evicted") {
+		parser.enable_validation_cache(1);
+
+		REQUIRE(parser.run_line("-m a", output, errors) == true);
+		REQUIRE(parser.run_line("-m b", output, errors) == true);
+		REQUIRE(parser.run_line("-m a", output, errors) == true);
+		REQUIRE(validations == 3);
+	}
+
+	SECTION("options are told apart in overlays") {
+		parser.enable_validation_cache();
+		REQUIRE(parser.run_line("", output, errors) == true);
+
+		for (int i = 0; i < 20; ++i)
+		{
+			REQUIRE(parser.overlay().run({ "-m", "x" }, output, errors) == true);
+			REQUIRE(parser.overlay().run({ "-t", "x" }, output, errors) == false);
+		}
+
+		REQUIRE(validations == 1);
+		REQUIRE(parser.validation_cache_statistics().misses == 2u);
+		REQUIRE(parser.validation_cache_statistics().hits == 38u);
+	}
+}
+
+TEST_CASE( "Cache conversions of repeated tokens", "[conversion] [cache]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::vector<int>>("n", "numbers", std::vector<int>());
+	parser.set_optional<double>("r", "ratio", 1.0);
+	parser.enable_conversion_cache();
+
+	REQUIRE(parser.run_line("-n 1 2 1 2 3 -r 0.5", output, errors) == true);
+	REQUIRE(parser.get<std::vector<int>>("n") == std::vector<int>({ 1, 2, 1, 2, 3 }));
+	REQUIRE(parser.conversion_cache_statistics().hits == 2u);
+	REQUIRE(parser.conversion_cache_statistics().misses == 4u);
+
+	REQUIRE(parser.run_line("-n 3 -r 0.5", output, errors) == true);
+	REQUIRE(parser.get<std::vector<int>>("n") == std::vector<int>({ 3 }));
+	REQUIRE(parser.get<double>("r") == 0.5);
+	REQUIRE(parser.conversion_cache_statistics().hits == 4u);
+
+	parser.clear_conversion_cache();
+	REQUIRE(parser.run_line("-r 0.5", output, errors) == true);
+	REQUIRE(parser.conversion_cache_statistics().misses == 5u);
+	REQUIRE(parser.run_line("-n x", output, errors) == false);
+}
+
+TEST_CASE( "Cache conversions of moved string tokens", "[conversion] [cache]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.set_optional<std::string>("s", "string", "default");
+	parser.enable_conversion_cache();
+
+	REQUIRE(parser.run_line("-s first", output, errors) == true);
+	REQUIRE(parser.get<std::string>("s") == "first");
+
+	REQUIRE(parser.run_line("-s ''", output, errors) == true);
+	REQUIRE(parser.get<std::string>("s") == "");
+	REQUIRE(parser.conversion_cache_statistics().misses == 2u);
+
+	REQUIRE(parser.run_line("-s first", output, errors) == true);
+	REQUIRE(parser.get<std::string>("s") == "first");
+	REQUIRE(parser.conversion_cache_statistics().hits == 1u);
+}
+
+TEST_CASE( "Reparse only changed options", "[reparse]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	int validations = 0;
+	auto count = [&](const int&, std::ostream&, std::ostream&) { ++validations; return true; };
+
+	Parser parser;
+	parser.set_optional<int>("a", "alpha", 1, "", count);
+	parser.set_optional<int>("b", "beta", 2, "", count);
+
+	const char* first[5] = { "myapp", "-a", "10", "-b", "20" };
+	REQUIRE(parser.reparse(5, first, output, errors) == true);
+	REQUIRE(validations == 2);
+
+	const char* second[5] = { "myapp", "-a", "10", "-b", "30" };
+	REQUIRE(parser.reparse(5, second, output, errors) == true);
+	REQUIRE(validations == 3);
+	REQUIRE(parser.get<int>("a") == 10);
+	REQUIRE(parser.get<int>("b") == 30);
+
+	const char* third[3] = { "myapp", "-b", "30" };
+	REQUIRE(parser.reparse(3, third, output, errors) == true);
+	REQUIRE(validations == 3);
+	REQUIRE(parser.get<int>("a") == 1);
+	REQUIRE(parser.get<int>("b") == 30);
+
+	const char* fourth[3] = { "myapp", "-a", "x" };
+	REQUIRE(parser.reparse(3, fourth, output, errors) == false);
+	REQUIRE(parser.reparse(5, second, output, errors) == true);
+	REQUIRE(parser.get<int>("a") == 10);
+	REQUIRE(parser.get<int>("b") == 30);
+}
+
+TEST_CASE( "Reparse a flag whose validation failed", "[reparse]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	auto allowed = true;
+	auto check = [&](const bool&, std::ostream&, std::ostream&) { return allowed; };
+
+	Parser parser;
+	parser.set_optional<bool>("v", "verbose", false, "", check);
+
+	const char* args[2] = { "myapp", "-v" };
+	allowed = false;
+	REQUIRE(parser.reparse(2, args, output, errors) == false);
+	REQUIRE(parser.get<bool>("v") == false);
+
+	allowed = true;
+	REQUIRE(parser.reparse(2, args, output, errors) == true);
+	REQUIRE(parser.get<bool>("v") == true);
+	REQUIRE(parser.reparse(2, args, output, errors) == true);
+	REQUIRE(parser.get<bool>("v") == true);
+}
+
+TEST_CASE( "Reparse lazily after a failed conversion", "[reparse] [lazy]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.enable_lazy_parsing();
+	parser.set_optional<int>("n", "number", 0);
+
+	const char* invalid[3] = { "myapp", "-n", "x" };
+	REQUIRE(parser.reparse(3, invalid, output, errors) == true);
+	REQUIRE_THROWS(parser.get<int>("n"));
+
+	const char* valid[3] = { "myapp", "-n", "5" };
+	REQUIRE(parser.reparse(3, valid, output, errors) == true);
+	REQUIRE(parser.get<int>("n") == 5);
+}
+
+TEST_CASE( "Restore values from a snapshot", "[snapshot]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	auto configure = [](Parser& parser) {
+		parser.set_optional<int>("n", "number", 1);
+		parser.set_optional<std::vector<std::string>>("f", "files", std::vector<std::string>());
+		parser.set_optional<NumericalBase<int, 16>>("x", "hex", 0);
+		parser.set_optional<bool>("v", "verbose", false);
+	};
+
+	const char* args[7] = { "myapp", "-n", "42", "-f", "a", "b c", "-v" };
+	Parser parser(7, args);
+	configure(parser);
+	REQUIRE(parser.run(output, errors) == true);
+
+	SECTION("from a blob") {
+		Parser child(1, args);
+		configure(child);
+		REQUIRE(child.restore(parser.snapshot(), errors) == true);
+		REQUIRE(child.get<int>("n") == 42);
+		REQUIRE(child.get<std::vector<std::string>>("f") == std::vector<std::string>({ "a", "b c" }));
+		REQUIRE(child.get<bool>("v") == true);
+		REQUIRE(child.get<NumericalBase<int, 16>>("x").value == 0);
+	}
+
+	SECTION("of a different schema") {
+		Parser child;
+		child.set_optional<int>("n", "number", 1);
+		REQUIRE(child.restore(parser.snapshot(), errors) == false);
+		REQUIRE(child.restore(std::string("garbage"), errors) == false);
+	}
+
+	SECTION("with a failed lazy conversion") {
+		const char* invalid[3] = { "myapp", "-n", "abc" };
+		Parser lazy(3, invalid);
+		configure(lazy);
+		lazy.enable_lazy_parsing();
+		REQUIRE(lazy.run(output, errors) == true);
+
+		Parser child(1, args);
+		configure(child);
+		REQUIRE_NOTHROW(child.restore(lazy.snapshot(), errors));
+		REQUIRE(child.restore(lazy.snapshot(), errors) == false);
+		REQUIRE(errors.str().find("ERROR: The value of 'n' is not part of the snapshot.") != std::string::npos);
+		REQUIRE_THROWS(lazy.get<int>("n"));
+	}
+
+#if defined(__linux__)
+	SECTION("from a memory file") {
+		const int fd = parser.export_snapshot();
+		REQUIRE(fd >= 0);
+
+		Parser child(1, args);
+		configure(child);
+		REQUIRE(child.restore_from(fd, errors) == true);
+		REQUIRE(child.get<int>("n") == 42);
+		close(fd);
+	}
+#endif
+}
+
+TEST_CASE( "Resolve values through overlays", "[overlay]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[5] = { "myapp", "-n", "1", "-m", "base" };
+	Parser parser(5, args);
+	parser.set_optional<int>("n", "number", 0);
+	parser.set_optional<std::string>("m", "model", "");
+	parser.set_optional<std::vector<int>>("l", "list", std::vector<int>(), "", [](const std::vector<int>& values, std::ostream&, std::ostream&) {
+		return values.size() < 3;
+	});
+	REQUIRE(parser.run(output, errors) == true);
+
+	auto task = parser.overlay();
+	REQUIRE(task.run({ "-n", "-2", "-l", "1", "2" }, output, errors) == true);
+	REQUIRE(task.get<int>("n") == -2);
+	REQUIRE(task.get<std::string>("m") == "base");
+	REQUIRE(task.get<std::vector<int>>("l") == std::vector<int>({ 1, 2 }));
+	REQUIRE(task.memory_usage() < parser.memory_usage());
+
+	auto subtask = task.overlay();
+	REQUIRE(subtask.run({ "--model", "sub" }, output, errors) == true);
+	REQUIRE(subtask.get<int>("n") == -2);
+	REQUIRE(subtask.get<std::string>("m") == "sub");
+
+	REQUIRE(parser.get<int>("n") == 1);
+	REQUIRE(parser.get<std::string>("m") == "base");
+
+	REQUIRE(task.run({ "-l", "1", "2", "3" }, output, errors) == false);
+	REQUIRE(task.run({ "-n", "1", "-n", "2" }, output, errors) == false);
+	REQUIRE(task.run({ "-x" }, output, errors) == false);
+}
+
+TEST_CASE( "Store stacked overlays in a container", "[overlay]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[3] = { "myapp", "-n", "1" };
+	Parser parser(3, args);
+	parser.set_optional<int>("n", "number", 0);
+	parser.set_optional<int>("m", "model", 0);
+	REQUIRE(parser.run(output, errors) == true);
+
+	std::vector<Parser::Overlay> layers { };
+	layers.push_back(parser.overlay());
+	REQUIRE(layers.back().run({ "-m", "7" }, output, errors) == true);
+
+	auto child = layers.back().overlay();
+	REQUIRE(child.run({ "-n", "2" }, output, errors) == true);
+
+	// Growing the container moves the overlays the child is stacked on.
+	for (int i = 0; i < 100; ++i)
+		layers.push_back(parser.overlay());
+
+	REQUIRE(child.get<int>("m") == 7);
+	REQUIRE(child.get<int>("n") == 2);
+
+	// The child keeps the layers below alive.
+	layers.clear();
+	REQUIRE(child.get<int>("m") == 7);
+}
+
+TEST_CASE( "Run overlays like the parser", "[overlay]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	const char* args[4] = { "myapp", "-v", "--number", "1" };
+	Parser parser(4, args);
+	parser.set_optional<bool>("v", "verbose", false);
+	parser.set_optional<int>("n", "number", 0);
+	parser.set_optional<std::string>("m", "model", "");
+	parser.enable_abbreviations();
+	REQUIRE(parser.run(output, errors) == true);
+	REQUIRE(parser.get<bool>("v") == true);
+
+	auto task = parser.overlay();
+	REQUIRE(task.run({ "-v", "--num", "2", "-m", "--", "-file" }, output, errors) == true);
+	REQUIRE(task.get<bool>("v") == true);
+	REQUIRE(task.get<int>("n") == 2);
+	REQUIRE(task.get<std::string>("m") == "-file");
+
+	parser.enable_forwarding();
+	REQUIRE(task.run({ "--child", "value", "-n", "3", "--", "-v" }, output, errors) == true);
+	REQUIRE(task.get<int>("n") == 3);
+	REQUIRE(task.get<bool>("v") == true);
+	REQUIRE(task.forwarded() == std::vector<std::string>({ "--child", "value", "-v" }));
+}
+
+TEST_CASE( "Read live options through handles", "[live]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	auto level = parser.set_live<int>("l", "level", 1, "", [](const int& value, std::ostream&, std::ostream&) {
+		return value >= 0;
+	});
+	auto name = parser.set_live<std::string>("n", "name", "default");
+
+	REQUIRE(level.load() == 1);
+	REQUIRE(name.load() == "default");
+
+	REQUIRE(parser.run_line("-l 3 -n first", output, errors) == true);
+	REQUIRE(level.load() == 3);
+	REQUIRE(parser.get<int>("l") == 3);
+	REQUIRE(name.load() == "first");
+
+	REQUIRE(parser.run_line("-l -1", output, errors) == false);
+	REQUIRE(level.load() == 3);
+	REQUIRE(parser.get_if<int>("l", [](int value) { return value + 1; }) == 4);
+	REQUIRE_THROWS_WITH(parser.get_ref<int>("l"), "The value of the live parameter l can only be copied, e.g. by get.");
+	REQUIRE_THROWS(parser.take<int>("l"));
+
+	std::atomic<bool> done(false);
+	std::atomic<bool> consistent(true);
+	std::vector<std::thread> readers { };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		readers.emplace_back([&]() {
+			while (!done)
+			{
+				const auto value = name.load();
+				const auto current = level.load();
+
+				if (value != "first" && value.compare(0, 6, "second") != 0)
+					consistent = false;
+
+				if (current < 3 || current > 102)
+					consistent = false;
+			}
+		});
+	}
+
+	for (int i = 0; i < 100; ++i)
+		REQUIRE(parser.run_line("-n second" + std::to_string(i) + " -l " + std::to_string(i + 3), output, errors) == true);
+
+	done = true;
+
+	for (auto& reader : readers)
+		reader.join();
+
+	REQUIRE(consistent);
+	REQUIRE(name.load() == "second99");
+	REQUIRE(level.load() == 102);
+	REQUIRE(parser.live_view().get(level) == 102);
+}
+
+TEST_CASE( "Read wide live options", "[live]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	auto ratio = parser.set_live<long double>("r", "ratio", 0.5L);
+	auto offset = parser.set_live<NumericalBase<long long>>("o", "offset", 1);
+
+	REQUIRE(parser.run_line("-r 2.25 -o 0x10", output, errors) == true);
+	REQUIRE(ratio.load() == 2.25L);
+	REQUIRE(parser.get<long double>("r") == 2.25L);
+	REQUIRE(offset.load().value == 16);
+	REQUIRE(parser.update("ratio", "4.5", output, errors) == true);
+	REQUIRE(ratio.load() == 4.5L);
+}
+
+TEST_CASE( "Parse live flags from their default", "[live]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	auto verbose = parser.set_live<bool>("v", "verbose", false);
+
+	REQUIRE(parser.run_line("-v", output, errors) == true);
+	REQUIRE(verbose.load() == true);
+	REQUIRE(parser.run_line("-v", output, errors) == true);
+	REQUIRE(verbose.load() == true);
+}
+
+TEST_CASE( "Update live options at runtime", "[live] [admin]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	auto batch = parser.set_live<int>("b", "batch", 8, "", [](const int& value, std::ostream&, std::ostream&) {
+		return value > 0;
+	});
+	parser.set_optional<int>("n", "number", 1);
+	REQUIRE(parser.run_line("", output, errors) == true);
+
+	SECTION("directly") {
+		REQUIRE(parser.update("b", "16", output, errors) == true);
+		REQUIRE(batch.load() == 16);
+		REQUIRE(parser.update("b", "0", output, errors) == false);
+		REQUIRE(parser.update("n", "2", output, errors) == false);
+		REQUIRE(batch.load() == 16);
+		REQUIRE(parser.update("batch", "24", output, errors) == true);
+		REQUIRE(batch.load() == 24);
+	}
+
+	SECTION("flags by explicit values") {
+		auto verbose = parser.set_live<bool>("v", "verbose", false);
+
+		REQUIRE(parser.update("verbose", "true", output, errors) == true);
+		REQUIRE(verbose.load() == true);
+		REQUIRE(parser.update("v", "true", output, errors) == true);
+		REQUIRE(verbose.load() == true);
+		REQUIRE(parser.update("v", "0", output, errors) == true);
+		REQUIRE(verbose.load() == false);
+		REQUIRE(parser.update("v", "maybe", output, errors) == false);
+		REQUIRE(parser.update("v", "", output, errors) == false);
+		REQUIRE(verbose.load() == false);
+
+		REQUIRE(parser.run_line("-v", output, errors) == true);
+		REQUIRE(verbose.load() == true);
+	}
+
+	SECTION("lists by several values") {
+		auto sizes = parser.set_live<std::vector<int>>("s", "sizes", { 1 });
+
+		REQUIRE(parser.update("sizes", "4 5 6", output, errors) == true);
+		REQUIRE(sizes.load() == std::vector<int>({ 4, 5, 6 }));
+		REQUIRE(parser.update("s", "'7'", output, errors) == true);
+		REQUIRE(sizes.load() == std::vector<int>({ 7 }));
+		REQUIRE(parser.update("s", "8 x", output, errors) == false);
+		REQUIRE(sizes.load() == std::vector<int>({ 7 }));
+
+		REQUIRE(parser.update("b", "16 32", output, errors) == false);
+		REQUIRE(errors.str().find("takes a single value") != std::string::npos);
+		REQUIRE(batch.load() == 8);
+	}
+
+#if defined(__linux__)
+	SECTION("through the admin socket") {
+		const char* directory = std::getenv("TMPDIR");
+		const std::string path = std::string(directory != nullptr ? directory : "/tmp") + "/cmdparser_admin_test.sock";
+		REQUIRE(parser.start_admin_socket(path, errors) == true);
+
+		Parser other;
+		REQUIRE(other.start_admin_socket(path, errors) == false);
+		REQUIRE(errors.str().find("is in use") != std::string::npos);
+
+		sockaddr_un address { };
+		address.sun_family = AF_UNIX;
+		std::strcpy(address.sun_path, path.c_str());
+		const int client = socket(AF_UNIX, SOCK_STREAM, 0);
+		REQUIRE(connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+
+		const std::string requests = "list\nset batch 32\nset b -1\nset x 1\nlist\n";
+		REQUIRE(write(client, requests.data(), requests.size()) == static_cast<ssize_t>(requests.size()));
+
+		std::string responses { };
+		char buffer[256];
+
+		while (std::count(responses.begin(), responses.end(), '\n') < 5 || responses.find("b 32\nOK\n") == std::string::npos)
+		{
+			const auto size = read(client, buffer, sizeof(buffer));
+			REQUIRE(size > 0);
+			responses.append(buffer, static_cast<size_t>(size));
+		}
+
+		close(client);
+		parser.stop_admin_socket();
+
+		REQUIRE(responses.find("b 8\nOK\nOK\n") == 0);
+		REQUIRE(responses.find("cannot be changed at runtime") != std::string::npos);
+		REQUIRE(responses.find("ERROR\n") != std::string::npos);
+		REQUIRE(responses.compare(responses.size() - 8, 8, "b 32\nOK\n") == 0);
+		REQUIRE(batch.load() == 32);
+	}
+
+	SECTION("lists through the admin socket") {
+		auto sizes = parser.set_live<std::vector<int>>("s", "sizes", { 1 });
+
+		const char* directory = std::getenv("TMPDIR");
+		const std::string path = std::string(directory != nullptr ? directory : "/tmp") + "/cmdparser_admin_test.sock";
+		REQUIRE(parser.start_admin_socket(path, errors) == true);
+
+		sockaddr_un address { };
+		address.sun_family = AF_UNIX;
+		std::strcpy(address.sun_path, path.c_str());
+		const int client = socket(AF_UNIX, SOCK_STREAM, 0);
+		REQUIRE(connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+
+		const std::string requests = "set sizes 4 5 6\nset batch 16 32\n";
+		REQUIRE(write(client, requests.data(), requests.size()) == static_cast<ssize_t>(requests.size()));
+
+		std::string responses { };
+		char buffer[256];
+
+		while (responses.size() < 4 || responses.compare(responses.size() - 6, 6, "ERROR\n") != 0)
+		{
+			const auto size = read(client, buffer, sizeof(buffer));
+			REQUIRE(size > 0);
+			responses.append(buffer, static_cast<size_t>(size));
+		}
+
+		close(client);
+		parser.stop_admin_socket();
+
+		REQUIRE(responses.find("OK\n") == 0);
+		REQUIRE(responses.find("takes a single value") != std::string::npos);
+		REQUIRE(sizes.load() == std::vector<int>({ 4, 5, 6 }));
+		REQUIRE(batch.load() == 8);
+	}
+
+	SECTION("without waiting for slow clients") {
+		const char* directory = std::getenv("TMPDIR");
+		const std::string path = std::string(directory != nullptr ? directory : "/tmp") + "/cmdparser_admin_test.sock";
+		REQUIRE(parser.start_admin_socket(path, errors) == true);
+
+		sockaddr_un address { };
+		address.sun_family = AF_UNIX;
+		std::strcpy(address.sun_path, path.c_str());
+		const int client = socket(AF_UNIX, SOCK_STREAM, 0);
+		REQUIRE(connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+
+		// The client never reads, so the responses fill the socket and then the server's buffer.
+		std::string requests { };
+
+		for (int i = 0; i < 1000; ++i)
+			requests += "list\n";
+
+		for (int i = 0; i < 100; ++i)
+			send(client, requests.data(), requests.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+
+		parser.stop_admin_socket();
+		close(client);
+		REQUIRE(batch.load() == 8);
+	}
+#endif
+}
+
+TEST_CASE( "Reload live options from a configuration file", "[live] [reload]" ) {
+	const char* directory = std::getenv("TMPDIR");
+	const std::string path = std::string(directory != nullptr ? directory : "/tmp") + "/cmdparser_reload_test.conf";
+	const auto write = [&path](const std::string& content) {
+		std::ofstream(path) << content;
+	};
+
+	Parser parser;
+	auto batch = parser.set_live<int>("b", "batch", 8, "", [](const int& value, std::ostream&, std::ostream& error) {
+		if (value > 0)
+			return true;
+
+		error << "The batch size must be positive." << std::endl;
+		return false;
+	});
+	auto model = parser.set_live<std::string>("m", "model", "small");
+	parser.set_optional<int>("n", "number", 1);
+
+	SECTION("valid files are applied") {
+		write("--batch 16\n--model 'large model'\n");
+		REQUIRE(parser.reload(path).empty());
+		REQUIRE(batch.load() == 16);
+		REQUIRE(model.load() == "large model");
+
+		write("--model medium\n");
+		REQUIRE(parser.reload(path).empty());
+		REQUIRE(batch.load() == 8);
+		REQUIRE(model.load() == "medium");
+		REQUIRE(parser.live_view().get(batch) == 8);
+	}
+
+	SECTION("values of the command line survive") {
+		std::stringstream output { };
+		std::stringstream errors { };
+		REQUIRE(parser.run_line("--batch 32", output, errors) == true);
+		REQUIRE(parser.update("model", "tiny", output, errors) == true);
+
+		write("--model medium\n");
+		REQUIRE(parser.reload(path).empty());
+		REQUIRE(batch.load() == 32);
+		REQUIRE(model.load() == "medium");
+
+		write("--batch 4\n");
+		REQUIRE(parser.reload(path).empty());
+		write("");
+		REQUIRE(parser.reload(path).empty());
+		REQUIRE(batch.load() == 32);
+		REQUIRE(model.load() == "small");
+	}
+
+	SECTION("invalid files change nothing") {
+		write("--model large -b 0 -n 2");
+		const auto diagnostics = parser.reload(path);
+		REQUIRE(diagnostics.size() == 3u);
+		REQUIRE(diagnostics[0].option == "n");
+		REQUIRE(diagnostics[1].message == "The argument '2' is invalid in this context.");
+		REQUIRE(diagnostics[2].option == "b");
+		REQUIRE(diagnostics[2].message == "The batch size must be positive.");
+		REQUIRE(batch.load() == 8);
+		REQUIRE(model.load() == "small");
+
+		REQUIRE(parser.reload("cmdparser_missing.conf").size() == 1u);
+	}
+
+	SECTION("values change together") {
+		std::atomic<bool> done(false);
+		std::atomic<bool> consistent(true);
+		std::thread reader([&]() {
+			while (!done)
+			{
+				const auto view = parser.live_view();
+				const auto size = view.get(batch);
+
+				if (view.get(model) != (size == 8 ? "small" : "model" + std::to_string(size)))
+					consistent = false;
+			}
+		});
+
+		for (int i = 1; i <= 100; ++i)
+		{
+			write("-b " + std::to_string(i + 8) + " -m model" + std::to_string(i + 8));
+			REQUIRE(parser.reload(path).empty());
+		}
+
+		done = true;
+		reader.join();
+		REQUIRE(consistent);
+		REQUIRE(batch.load() == 108);
+		REQUIRE(model.load() == "model108");
+	}
+
+#if defined(__linux__)
+	SECTION("changed files are reloaded") {
+		write("");
+		std::atomic<int> reloads(0);
+		REQUIRE(parser.watch_config(path, [&reloads](const std::vector<Diagnostic>& diagnostics) {
+			if (diagnostics.empty())
+				++reloads;
+		}) == true);
+
+		write("-b 32");
+
+		for (int i = 0; i < 500 && reloads == 0; ++i)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+		parser.unwatch_config();
+		REQUIRE(reloads > 0);
+		REQUIRE(batch.load() == 32);
+	}
+#endif
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE( "Discover global options", "[global]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	REQUIRE(parser.run_line("--test-threads 8", output, errors) == false);
+
+	parser.enable_global_options();
+	REQUIRE(parser.run_line("--test-threads 8 --test-model large", output, errors) == true);
+	REQUIRE(cmdparser_test_threads == 8);
+	REQUIRE(cmdparser_test_model == "large");
+	REQUIRE(parser.get<int>("T") == 8);
+	REQUIRE(&parser.get_ref<int>("T") == &cmdparser_test_threads);
+	REQUIRE(parser.get_if<std::string>("M", [](std::string value) { return value + "!"; }) == "large!");
+	REQUIRE_THROWS(parser.take<std::string>("M"));
+
+	REQUIRE(parser.run_line("--test-threads x", output, errors) == false);
+	REQUIRE(parser.run_line("-M medium", output, errors) == true);
+	REQUIRE(cmdparser_test_threads == 4);
+	REQUIRE(cmdparser_test_model == "medium");
+
+	// Parsers that are not given an option leave its variable alone.
+	Parser other;
+	other.enable_global_options();
+	cmdparser_test_threads = 16;
+	REQUIRE(other.run_line("", output, errors) == true);
+	REQUIRE(cmdparser_test_threads == 16);
+
+	REQUIRE(parser.run_line("", output, errors) == true);
+	REQUIRE(cmdparser_test_threads == 16);
+	REQUIRE(cmdparser_test_model == "small");
+	cmdparser_test_threads = 4;
+
+	// Children restore a snapshot before their first run.
+	REQUIRE(parser.run_line("-M large", output, errors) == true);
+	Parser child;
+	child.enable_global_options();
+	REQUIRE(child.restore(parser.snapshot(), errors) == true);
+	REQUIRE(child.get<std::string>("M") == "large");
+
+	Parser fresh;
+	fresh.enable_global_options();
+	REQUIRE(child.restore(fresh.snapshot(), errors) == true);
+	REQUIRE(parser.run_line("", output, errors) == true);
+	REQUIRE(cmdparser_test_model == "small");
+}
+
+TEST_CASE( "Discover global options of a library", "[global] [library]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.enable_global_options();
+	REQUIRE(parser.run_line("-B 3", output, errors) == false);
+	REQUIRE(parser.run_line("-T 8", output, errors) == true);
+
+	parser.enable_global_options(cmdparser_test_library());
+	parser.enable_global_options(cmdparser_test_library());
+	REQUIRE(parser.run_line("-B 3 -T 8", output, errors) == true);
+	REQUIRE(cmdparser_test_library_batch() == 3);
+	REQUIRE(parser.get<int>("B") == 3);
+	REQUIRE(parser.commands() == 3);
+
+	REQUIRE(parser.run_line("", output, errors) == true);
+	REQUIRE(cmdparser_test_library_batch() == 2);
+	REQUIRE(cmdparser_test_threads == 4);
+}
+
+TEST_CASE( "Parse global options in lazy mode", "[global] [lazy]" ) {
+	std::stringstream output { };
+	std::stringstream errors { };
+
+	Parser parser;
+	parser.enable_global_options();
+	parser.enable_lazy_parsing();
+
+	REQUIRE(parser.run_line("-T 8", output, errors) == true);
+	REQUIRE(cmdparser_test_threads == 8);
+	REQUIRE(parser.get<int>("T") == 8);
+
+	REQUIRE(parser.run_line("-T x", output, errors) == false);
+	REQUIRE(parser.run_line("", output, errors) == true);
+	REQUIRE(cmdparser_test_threads == 4);
+}
@@ -4,12 +4,108 @@
 */
 
 #pragma once
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <sstream>
+#include <fstream>
 #include <functional>
+#include <memory>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <chrono>
+#include <list>
+#include <unordered_map>
+#include <type_traits>
+#include <cerrno>
+#include <cassert>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+/// Building blocks for a usage text that is assembled by the compiler and passed to
+/// Parser::set_static_usage. The entries produce the same text as the generated usage.
+#define CMDPARSER_USAGE_HEADER "Available parameters:\n\n"
+#define CMDPARSER_USAGE_GENERAL(text) text "\n\n" CMDPARSER_USAGE_HEADER
+#define CMDPARSER_USAGE_REQUIRED(name, alternative, description) \
+	"\t-" name ",\t--" alternative "\n\t\t(required)" description "\n\n"
+#define CMDPARSER_USAGE_OPTIONAL(name, alternative, defaultValue, description) \
+	"\t-" name ",\t--" alternative "\n\t\tDefault:\t'" defaultValue "'\n\t\t[optional] " description "\n\n"
+#define CMDPARSER_USAGE_HELP CMDPARSER_USAGE_OPTIONAL("h", "help", "", "")
+/// Optional entry whose default value is not known at compile time. It is rendered
+/// through the option's current value whenever the help is printed.
+#define CMDPARSER_USAGE_RUNTIME(name, alternative, description) \
+	CMDPARSER_USAGE_OPTIONAL(name, alternative, "\x1a" name "\x1a", description)
+
+/// Defines a global option near the code using it, which parsers pick up once their global
+/// options are enabled (see Parser::enable_global_options). The value is stored in the
+/// variable cmdparser_<name>; other translation units declare it by CMDPARSER_DECLARE.
+/// The option is given as -<shortName> or --<alternative>, shortName must not be empty.
+/// On ELF platforms the descriptors are constants in a section of their own, hence
+/// nothing runs at startup (besides the constructor of the variable, e.g. of a string).
+/// Options defined in a shared library are only found through CMDPARSER_GLOBAL_LIBRARY.
+#define CMDPARSER_GLOBAL(type, name, shortName, alternative, defaultValue, description) \
+	type cmdparser_##name = defaultValue; \
+	CMDPARSER_GLOBAL_SECTION const cli::GlobalOption cmdparser_option_##name = { shortName, alternative, description, &cmdparser_##name, &cli::add_global<type> }; \
+	CMDPARSER_GLOBAL_REGISTRATION(name)
+#define CMDPARSER_DECLARE(type, name) extern type cmdparser_##name
+
+/// Defines the function cli::GlobalOptions <function>() returning the global options of the
+/// shared library (or executable) it is compiled into, which is passed to
+/// Parser::enable_global_options. The library has to export the function.
+#define CMDPARSER_GLOBAL_LIBRARY(function) \
+	cli::GlobalOptions function() { return CMDPARSER_GLOBAL_OPTIONS; }
+
+#if defined(__ELF__)
+// Nothing refers to the descriptors, retain keeps the linker from discarding them with --gc-sections.
+#if defined(__has_attribute)
+#if __has_attribute(retain)
+#define CMDPARSER_GLOBAL_RETAIN retain,
+#endif
+#endif
+#if !defined(CMDPARSER_GLOBAL_RETAIN)
+#define CMDPARSER_GLOBAL_RETAIN
+#endif
+// The explicit alignment keeps compilers from padding the descriptors, which are read as an array.
+#define CMDPARSER_GLOBAL_SECTION __attribute__((used, CMDPARSER_GLOBAL_RETAIN section("cmdparser_options"), aligned(sizeof(void*))))
+#define CMDPARSER_GLOBAL_REGISTRATION(name)
+#define CMDPARSER_GLOBAL_OPTIONS cli::GlobalOptions { cli::__start_cmdparser_options, cli::__stop_cmdparser_options }
+#else
+#define CMDPARSER_GLOBAL_SECTION
+#define CMDPARSER_GLOBAL_REGISTRATION(name) static cli::GlobalRegistration cmdparser_registration_##name(&cmdparser_option_##name);
+#define CMDPARSER_GLOBAL_OPTIONS cli::GlobalOptions { cli::GlobalRegistration::first() }
+#endif
 
 namespace cli
 {
@@ -43,720 +139,4469 @@ namespace cli
 	};
 
 
+	/// Checks performed on path arguments, can be combined
+	struct PathCheck
+	{
+		enum : unsigned int
+		{
+			Exists = 1,
+			Readable = 2,
+			Directory = 4,
+			WritableParent = 8
+		};
+	};
+
+	/// Class used to wrap paths to specify the checks performed when validating the argument
+	template <unsigned int pathChecks = PathCheck::Exists>
+	class BasicPath
+	{
+	public:
+		BasicPath()
+		{}
+
+		/// This constructor required for default value initialization
+		/// \param path comes from default value
+		BasicPath(std::string path) : value(std::move(path))
+		{}
+
+		BasicPath(const char* path) : value(path)
+		{}
+
+		operator const std::string& () const
+		{
+			return this->value;
+		}
+
+		std::string value;
+	};
+
+	typedef BasicPath<PathCheck::Exists> Path;
+	typedef BasicPath<PathCheck::Exists | PathCheck::Readable> ReadablePath;
+	typedef BasicPath<PathCheck::Directory> Directory;
+	typedef BasicPath<PathCheck::WritableParent> OutputPath;
+
+	/// Tracks the readers of a value that is replaced while it is read. Readers announce
+	/// themselves in one of a few counters, each on a cache line of its own, picked by their
+	/// thread. Each counter has two halves, readers use the half of the current epoch, such
+	/// that a writer only waits for the readers that started before it replaced the value.
+	class ReaderSlots
+	{
+	public:
+		ReaderSlots() : _epoch(0)
+		{
+			for (auto& slot : _slots)
+			{
+				slot.count[0] = 0;
+				slot.count[1] = 0;
+			}
+		}
+
+		/// Announces a reader, the returned counter has to be decremented when it is done.
+		/// A writer may flip the epoch between reading it and announcing the reader; the
+		/// announcement is then retried in the new half, which the next writer waits for.
+		std::atomic<size_t>& enter() const
+		{
+			auto& slot = _slots[std::hash<std::thread::id>()(std::this_thread::get_id()) % Slots];
+
+			for (;;)
+			{
+				const auto epoch = _epoch.load();
+				auto& counter = slot.count[epoch & 1];
+				++counter;
+
+				if (_epoch.load() == epoch)
+					return counter;
+
+				--counter;
+			}
+		}
+
+		/// Waits until no reader can still see a value replaced before the call. Writers have
+		/// to be serialized by the caller.
+		void synchronize()
+		{
+			const auto half = _epoch++ & 1;
+
+			for (const auto& slot : _slots)
+			{
+				while (slot.count[half] != 0)
+					std::this_thread::yield();
+			}
+		}
+
+	private:
+		static const size_t CacheLine = 64;
+		static const size_t Slots = 8;
+
+		struct Slot
+		{
+			std::atomic<size_t> count[2];
+			char                padding[CacheLine - 2 * sizeof(std::atomic<size_t>)];
+		};
+
+		char                _before[CacheLine];
+		std::atomic<size_t> _epoch;
+		char                _after[CacheLine - sizeof(std::atomic<size_t>)];
+		mutable Slot        _slots[Slots];
+	};
+
+	/// Whether the value of a live option is kept in a LiveAtomic: only trivially copyable
+	/// values a processor can load at once, hence the atomic does not take a lock (or need
+	/// libatomic), e.g. not long double.
+	template <typename T>
+	struct IsLiveAtomic : std::integral_constant<bool,
+		std::is_trivially_copyable<T>::value && sizeof(T) <= sizeof(void*) && (sizeof(T) & (sizeof(T) - 1)) == 0>
+	{};
+
+	/// The current value of a live option (see IsLiveAtomic), stored in an atomic padded such
+	/// that no other data shares its cache lines. Handles read it without touching LiveState.
+	template <typename T>
+	class LiveAtomic
+	{
+	public:
+		explicit LiveAtomic(const T& value) : _value(value)
+		{}
+
+		T load() const
+		{
+			return _value.load(std::memory_order_acquire);
+		}
+
+		void store(const T& next)
+		{
+			_value.store(next, std::memory_order_release);
+		}
+
+	private:
+		static const size_t CacheLine = 64;
+
+		char           _before[CacheLine];
+		std::atomic<T> _value;
+		char           _after[CacheLine];
+	};
+
+	/// A change of a live option, see LiveState::publish. apply, if set, runs once the
+	/// generation containing the value is current.
+	struct LiveChange
+	{
+		size_t index;
+		std::shared_ptr<const void> value;
+		std::function<void()> apply;
+	};
+
+	/// The values of all live options of a parser. They are published together as an immutable
+	/// generation, such that readers see either all or none of the values changed at once.
+	/// A replaced generation is freed once the readers still copying from it are done and no
+	/// LiveView holds on to it.
+	class LiveState
+	{
+	public:
+		struct Generation
+		{
+			std::vector<std::shared_ptr<const void>> values;
+		};
+
+		LiveState() : _owner(std::make_shared<const Generation>())
+		{
+			_current = _owner.get();
+		}
+
+		template<typename T>
+		T load(size_t index) const
+		{
+			auto& reader = _readers.enter();
+			T value = *static_cast<const T*>(_current.load()->values[index].get());
+			--reader;
+			return value;
+		}
+
+		/// The current generation, it stays valid as long as it is referenced.
+		std::shared_ptr<const Generation> pin() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _owner;
+		}
+
+		/// Adds the value of another option, returns its index.
+		size_t add(std::shared_ptr<const void> value)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::shared_ptr<Generation> next(new Generation(*_owner));
+			next->values.push_back(std::move(value));
+			replace(std::move(next));
+			return _owner->values.size() - 1;
+		}
+
+		/// Publishes all changes with a single pointer swap.
+		void publish(const std::vector<LiveChange>& changes)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::shared_ptr<Generation> next(new Generation(*_owner));
+
+			for (const auto& change : changes)
+				next->values[change.index] = change.value;
+
+			replace(std::move(next));
+
+			for (const auto& change : changes)
+			{
+				if (change.apply)
+					change.apply();
+			}
+		}
+
+	private:
+		static const size_t CacheLine = 64;
+
+		void replace(std::shared_ptr<const Generation> next)
+		{
+			_current = next.get();
+			_readers.synchronize();
+			_owner = std::move(next);
+		}
+
+		char                           _before[CacheLine];
+		std::atomic<const Generation*> _current;
+		char                           _after[CacheLine];
+		ReaderSlots                    _readers;
+		mutable std::mutex             _mutex;
+		std::shared_ptr<const Generation> _owner;
+	};
+
+	/// Handle to an option that can be changed while the program runs, see Parser::set_live.
+	/// Reading its value never blocks. The handle stays valid after the parser is destroyed.
+	/// Small trivially copyable values are read from the option's own LiveAtomic, others from
+	/// the current generation.
+	template <typename T>
+	class Live
+	{
+	public:
+		Live(std::shared_ptr<LiveState> state, size_t index, std::shared_ptr<LiveAtomic<T>> atomic)
+			: _state(std::move(state)), _index(index), _atomic(std::move(atomic))
+		{}
+
+		T load() const
+		{
+			return load(typename IsLiveAtomic<T>::type());
+		}
+
+	private:
+		friend class LiveView;
+
+		T load(std::true_type) const
+		{
+			return _atomic->load();
+		}
+
+		T load(std::false_type) const
+		{
+			return _state->load<T>(_index);
+		}
+
+		std::shared_ptr<LiveState> _state;
+		size_t _index;
+		std::shared_ptr<LiveAtomic<T>> _atomic;
+	};
+
+	/// The values of the live options of a parser at one point in time, see Parser::live_view.
+	/// Values changed together, e.g. by a reload, are either all old or all new in a view.
+	class LiveView
+	{
+	public:
+		explicit LiveView(std::shared_ptr<const LiveState::Generation> generation) : _generation(std::move(generation))
+		{}
+
+		/// The value of an option registered before the view was taken.
+		template <typename T>
+		const T& get(const Live<T>& option) const
+		{
+			return *static_cast<const T*>(_generation->values[option._index].get());
+		}
+
+	private:
+		std::shared_ptr<const LiveState::Generation> _generation;
+	};
+
+
+
+	struct CallbackArgs
+	{
+		const std::vector<std::string>& arguments;
+		std::ostream& output;
+		std::ostream& error;
+	};
+
+
+	/// Shells for which Parser::completion_script can generate a completion script
+	enum class CompletionShell
+	{
+		Bash,
+		Zsh,
+		Fish
+	};
+
+
+	template<typename T>
+	using ValidationFunction = std::function<bool(const T&, std::ostream&, std::ostream&)>;
+
+
+	/// Hit and miss counters of the parser's caches
+	struct CacheStatistics
+	{
+		size_t hits;
+		size_t misses;
+	};
+
+
+	/// Receives the elements of a stream option one by one, returning false rejects the element.
+	template<typename T>
+	using ConsumerFunction = std::function<bool(T&&, std::ostream&, std::ostream&)>;
+
+
+	/// A problem found when reloading a configuration, option is empty if it concerns no option.
+	struct Diagnostic
+	{
+		std::string option;
+		std::string message;
+	};
+
+	using ReloadFunction = std::function<void(const std::vector<Diagnostic>&)>;
+
+
+	class Parser;
+
+	/// Describes an option defined by CMDPARSER_GLOBAL.
+	struct GlobalOption
+	{
+		const char* name;
+		const char* alternative;
+		const char* description;
+		void* storage;
+		void (*add)(Parser& parser, const GlobalOption& option);
+	};
+
+#if defined(__ELF__)
+	/// The bounds of the descriptor section, provided by the linker (null if it is empty).
+	/// Each executable and shared library has bounds of its own, the hidden visibility
+	/// makes the references resolve to those of the module containing the code.
+	extern "C" const GlobalOption __start_cmdparser_options[] __attribute__((weak, visibility("hidden")));
+	extern "C" const GlobalOption __stop_cmdparser_options[] __attribute__((weak, visibility("hidden")));
+
+	/// The global options of a module, see CMDPARSER_GLOBAL_LIBRARY.
+	struct GlobalOptions
+	{
+		const GlobalOption* begin;
+		const GlobalOption* end;
+	};
+#else
+	/// Links the descriptors together where there are no linker sections to collect them.
+	struct GlobalRegistration
+	{
+		explicit GlobalRegistration(const GlobalOption* option) : option(option), next(first())
+		{
+			first() = this;
+		}
+
+		static GlobalRegistration*& first()
+		{
+			static GlobalRegistration* registration = nullptr;
+			return registration;
+		}
+
+		const GlobalOption* option;
+		GlobalRegistration* next;
+	};
+
+	/// The global options of a module, see CMDPARSER_GLOBAL_LIBRARY.
+	struct GlobalOptions
+	{
+		const GlobalRegistration* first;
+	};
+#endif
+
+
+	class Parser
+	{
+	private:
+		/// FNV-1a, can be continued by passing the hash of the preceding bytes.
+		static size_t hash(const char* str, size_t length, size_t h = 2166136261u)
+		{
+			for (size_t i = 0; i < length; ++i)
+				h = (h ^ static_cast<unsigned char>(str[i])) * 16777619u;
+
+			return h;
+		}
+
+		/// Stores option names and descriptions back to back in a few large chunks.
+		/// Equal strings are stored only once.
+		class StringPool
+		{
+		public:
+			const char* intern(const std::string& str)
+			{
+				if (str.empty())
+					return "";
+
+				if ((_count + 1) * 2 > _slots.size())
+					grow();
+
+				auto& slot = _slots[probe(str.data(), str.size())];
+
+				if (slot == nullptr)
+				{
+					auto copy = allocate(str.size() + 1);
+					std::memcpy(copy, str.c_str(), str.size() + 1);
+					slot = copy;
+					++_count;
+				}
+
+				return slot;
+			}
+
+			const char* intern(const std::string& prefix, const std::string& str)
+			{
+				return str.empty() ? "" : intern(prefix + str);
+			}
+
+			/// Returns the number of bytes held by the pool, including its lookup table.
+			size_t memory_usage() const
+			{
+				return _bytes + _slots.capacity() * sizeof(const char*) + _chunks.capacity() * sizeof(std::unique_ptr<char[]>);
+			}
+
+		private:
+			static const size_t ChunkSize = 1024;
+
+			size_t probe(const char* str, size_t length) const
+			{
+				const size_t mask = _slots.size() - 1;
+				size_t i = Parser::hash(str, length) & mask;
+
+				while (_slots[i] != nullptr && (std::strncmp(_slots[i], str, length) != 0 || _slots[i][length] != '\0'))
+					i = (i + 1) & mask;
+
+				return i;
+			}
+
+			void grow()
+			{
+				std::vector<const char*> slots(_slots.empty() ? 16 : _slots.size() * 2, nullptr);
+				slots.swap(_slots);
+
+				for (const auto str : slots)
+				{
+					if (str != nullptr)
+						_slots[probe(str, std::strlen(str))] = str;
+				}
+			}
+
+			char* allocate(size_t size)
+			{
+				// Large strings get a chunk of their own, so the current chunk keeps its free space.
+				if (size > ChunkSize / 4)
+				{
+					_chunks.emplace_back(new char[size]);
+					_bytes += size;
+					return _chunks.back().get();
+				}
+
+				if (size > _remaining)
+				{
+					_chunks.emplace_back(new char[ChunkSize]);
+					_bytes += ChunkSize;
+					_free = _chunks.back().get();
+					_remaining = ChunkSize;
+				}
+
+				auto result = _free;
+				_free += size;
+				_remaining -= size;
+				return result;
+			}
+
+			std::vector<std::unique_ptr<char[]>> _chunks;
+			std::vector<const char*> _slots;
+			char* _free = nullptr;
+			size_t _remaining = 0;
+			size_t _count = 0;
+			size_t _bytes = 0;
+		};
+
+		class CmdBase;
+
+		struct ConversionCounters
+		{
+			std::atomic<size_t> hits;
+			std::atomic<size_t> misses;
+		};
+
+		/// Maps tokens to the values they have been converted to (open addressing, linear probing).
+		template<typename T>
+		class ConversionCache
+		{
+		public:
+			const T* find(const std::string& token) const
+			{
+				if (_slots.empty())
+					return nullptr;
+
+				const auto& slot = _slots[probe(token)];
+				return slot.used ? &slot.value : nullptr;
+			}
+
+			void insert(const std::string& token, const T& value)
+			{
+				if ((_count + 1) * 2 > _slots.size())
+					grow();
+
+				auto& slot = _slots[probe(token)];
+
+				if (!slot.used)
+				{
+					slot.used = true;
+					slot.token = token;
+					slot.value = value;
+					++_count;
+				}
+			}
+
+		private:
+			struct Slot
+			{
+				bool used = false;
+				std::string token;
+				T value;
+			};
+
+			size_t probe(const std::string& token) const
+			{
+				const size_t mask = _slots.size() - 1;
+				size_t i = Parser::hash(token.data(), token.size()) & mask;
+
+				while (_slots[i].used && _slots[i].token != token)
+					i = (i + 1) & mask;
+
+				return i;
+			}
+
+			void grow()
+			{
+				std::vector<Slot> slots(_slots.empty() ? 16 : _slots.size() * 2);
+				slots.swap(_slots);
+
+				for (auto& slot : slots)
+				{
+					if (slot.used)
+						_slots[probe(slot.token)] = std::move(slot);
+				}
+			}
+
+			std::vector<Slot> _slots;
+			size_t _count = 0;
+		};
+
+		/// Remembers the outcome of pure validators, including their output, for a bounded
+		/// time. The least recently used entry is dropped when the cache is full.
+		class ValidationCache
+		{
+		public:
+			ValidationCache(size_t capacity, std::chrono::steady_clock::duration ttl)
+				:	_capacity(capacity),
+					_ttl(ttl)
+			{
+			}
+
+			bool validate(const std::string& key, CmdBase* command, std::ostream& output, std::ostream& error)
+			{
+				Entry entry { };
+
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					const auto found = _index.find(key);
+
+					if (found != _index.end() && std::chrono::steady_clock::now() < found->second->expires)
+					{
+						_entries.splice(_entries.begin(), _entries, found->second);
+						entry = *found->second;
+						++_statistics.hits;
+					}
+					else
+					{
+						if (found != _index.end())
+						{
+							_entries.erase(found->second);
+							_index.erase(found);
+						}
+
+						++_statistics.misses;
+					}
+				}
+
+				if (entry.key.empty())
+				{
+					std::stringstream out { }, err { };
+					entry.valid = command->validate(out, err);
+					entry.output = out.str();
+					entry.error = err.str();
+					entry.expires = std::chrono::steady_clock::now() + _ttl;
+					entry.key = key;
+
+					std::lock_guard<std::mutex> lock(_mutex);
+
+					if (_index.find(key) == _index.end() && _capacity > 0)
+					{
+						_entries.push_front(entry);
+						_index[key] = _entries.begin();
+
+						if (_entries.size() > _capacity)
+						{
+							_index.erase(_entries.back().key);
+							_entries.pop_back();
+						}
+					}
+				}
+
+				output << entry.output;
+				error << entry.error;
+				return entry.valid;
+			}
+
+			CacheStatistics statistics() const
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				return _statistics;
+			}
+
+		private:
+			struct Entry
+			{
+				std::string key;
+				bool valid;
+				std::string output;
+				std::string error;
+				std::chrono::steady_clock::time_point expires;
+			};
+
+			const size_t _capacity;
+			const std::chrono::steady_clock::duration _ttl;
+			std::list<Entry> _entries;
+			std::unordered_map<std::string, std::list<Entry>::iterator> _index;
+			CacheStatistics _statistics { 0, 0 };
+			mutable std::mutex _mutex;
+		};
+
+		class CmdBase
+		{
+		public:
+			explicit CmdBase(StringPool& pool, const std::string& name, const std::string& alternative, const std::string& description, bool required, bool dominant, bool variadic)
+				:	command(pool.intern("-", name)),
+					alternative(pool.intern("--", alternative)),
+					description(pool.intern(description)),
+					arguments({}),
+					required(required),
+					handled(false),
+					pending(false),
+					terminating(false),
+					independent(false),
+					pure(false),
+					reusable(false),
+					runtime(false),
+					eager(false),
+					flag(false),
+					dominant(dominant),
+					variadic(variadic)
+			{
+			}
+
+			virtual ~CmdBase()
+			{
+			}
+
+
+			virtual std::string print_value() const = 0;
+			virtual bool parse(std::ostream& output, std::ostream& error) = 0;
+			virtual bool validate(std::ostream& output, std::ostream& error) = 0;
+			virtual size_t memory_usage() const = 0;
+
+			/// A fresh copy of this command with the same labels and default value, or null if it
+			/// cannot be copied.
+			virtual CmdBase* clone() const
+			{
+				return nullptr;
+			}
+
+			/// Makes the value validated last visible to readers (live options only).
+			virtual bool publish()
+			{
+				return true;
+			}
+
+			/// Adds the value validated last to changes published at once (live options only).
+			virtual void stage(std::vector<LiveChange>& /*changes*/) const
+			{
+			}
+
+			/// Appends the value to a snapshot, returns false if its type cannot be stored.
+			virtual bool store(std::string& /*blob*/) const
+			{
+				return false;
+			}
+
+			/// Takes the value from a snapshot.
+			virtual bool load(const char*& /*cursor*/, const char* /*end*/)
+			{
+				return false;
+			}
+
+			/// Starts using the given counters for a fresh conversion cache, or stops caching if null.
+			virtual void use_conversion_cache(ConversionCounters* /*counters*/)
+			{
+			}
+
+			/// Forgets everything about the previous run.
+			virtual void reset()
+			{
+				rewind();
+				reusable = false;
+			}
+
+			/// Puts the default value back, such that the arguments are parsed from it again.
+			virtual void restore()
+			{
+			}
+
+			/// Forgets the arguments of the previous run but keeps its value.
+			void rewind()
+			{
+				handled = false;
+				pending = false;
+				arguments.clear();
+			}
+
+			/// Takes the next argument of a variadic command.
+			virtual bool accept(std::string&& argument, std::ostream& /*output*/, std::ostream& /*error*/)
+			{
+				arguments.push_back(std::move(argument));
+				return true;
+			}
+
+			virtual std::string	usage() const
+			{
+				std::stringstream ss;
+
+				if(!*command && !*alternative)
+					ss << "\tDEFAULT" << std::endl;
+				else
+					ss << "\t" << command << ",\t" << alternative << std::endl;
+
+				if (required == true)
+				{
+					ss << "\t\t(required)";
+				}
+				else
+				{
+					ss << "\t\tDefault:\t'" + print_value() << "'" << std::endl;
+					ss << "\t\t[optional] ";
+				}
+
+				ss << description << std::endl << std::endl;
+
+				return ss.str();
+			}
+
+			bool is(const std::string& given) const
+			{
+				return given == command || given == alternative;
+			}
+
+			/// The name without its leading dash. It shares the pooled storage of command.
+			const char* name() const
+			{
+				return *command ? command + 1 : command;
+			}
+
+			/// Bytes used by the pooled labels of this command.
+			size_t label_memory_usage() const
+			{
+				size_t bytes = 0;
+
+				for (const auto label : { command, alternative, description })
+					bytes += *label ? std::strlen(label) + 1 : 0;
+
+				return bytes;
+			}
+
+		protected:
+			/// Bytes used by the labels and the collected arguments of this command.
+			size_t base_memory_usage() const
+			{
+				return label_memory_usage() + Parser::heap_size(arguments);
+			}
+
+		public:
+			const char*		command;
+			const char*		alternative;
+			const char*		description;
+			std::vector<std::string> arguments;
+			// The flags come last and take a single bit each, such that the value of a derived
+			// command can use the padding at the end (see memory_usage).
+			bool 			required : 1;
+			bool 			handled : 1;
+			bool 			pending : 1;
+			bool 			terminating : 1;
+			bool 			independent : 1;
+			bool 			pure : 1;
+			bool 			reusable : 1;
+			bool 			runtime : 1;
+			/// Set for options whose value is read without asking the parser, such that their
+			/// parsing cannot be deferred by the lazy mode.
+			bool 			eager : 1;
+			/// Set for options that take no arguments on the command line.
+			bool 			flag : 1;
+			bool const 		dominant : 1;
+			bool const 		variadic : 1;
+		};
+
+		template<typename T>
+		struct ArgumentCountChecker
+		{
+			static constexpr bool Variadic = false;
+		};
+
+		template<typename T>
+		struct ArgumentCountChecker<cli::NumericalBase<T>>
+		{
+			static constexpr bool Variadic = false;
+		};
+
+		template<typename T>
+		struct ArgumentCountChecker<std::vector<T>>
+		{
+			static constexpr bool Variadic = true;
+		};
+
+		/// The type a single token is converted to, i.e. the element type of lists
+		template<typename T>
+		struct ConvertedToken
+		{
+			typedef T Type;
+		};
+
+		template<typename T>
+		struct ConvertedToken<std::vector<T>>
+		{
+			typedef T Type;
+		};
+
+		/// Stores values in snapshots (see Parser::snapshot). Values are written in the byte
+		/// order of the machine, snapshots are meant for processes of the same program.
+		template<typename T, typename Enable = void>
+		struct Serializer
+		{
+			static constexpr bool Supported = false;
+
+			static void write(std::string&, const T&)
+			{
+			}
+
+			static bool read(const char*&, const char*, T&)
+			{
+				return false;
+			}
+		};
+
+		template<typename T>
+		struct Serializer<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+		{
+			static constexpr bool Supported = true;
+
+			static void write(std::string& blob, const T& value)
+			{
+				blob.append(reinterpret_cast<const char*>(&value), sizeof(value));
+			}
+
+			static bool read(const char*& cursor, const char* end, T& value)
+			{
+				if (static_cast<size_t>(end - cursor) < sizeof(value))
+					return false;
+
+				std::memcpy(&value, cursor, sizeof(value));
+				cursor += sizeof(value);
+				return true;
+			}
+		};
+
+		template<typename T>
+		struct Serializer<std::basic_string<T>>
+		{
+			static constexpr bool Supported = Serializer<T>::Supported;
+
+			static void write(std::string& blob, const std::basic_string<T>& value)
+			{
+				Serializer<uint64_t>::write(blob, value.size());
+				blob.append(reinterpret_cast<const char*>(value.data()), value.size() * sizeof(T));
+			}
+
+			static bool read(const char*& cursor, const char* end, std::basic_string<T>& value)
+			{
+				uint64_t size = 0;
+
+				if (!Serializer<uint64_t>::read(cursor, end, size) || size > static_cast<uint64_t>(end - cursor) / sizeof(T))
+					return false;
+
+				value.resize(static_cast<size_t>(size));
+				std::memcpy(&value[0], cursor, value.size() * sizeof(T));
+				cursor += value.size() * sizeof(T);
+				return true;
+			}
+		};
+
+		template<typename T>
+		struct Serializer<std::vector<T>>
+		{
+			static constexpr bool Supported = Serializer<T>::Supported;
+
+			static void write(std::string& blob, const std::vector<T>& values)
+			{
+				Serializer<uint64_t>::write(blob, values.size());
+
+				for (const auto& value : values)
+					Serializer<T>::write(blob, value);
+			}
+
+			static bool read(const char*& cursor, const char* end, std::vector<T>& values)
+			{
+				uint64_t size = 0;
+
+				if (!Serializer<uint64_t>::read(cursor, end, size) || size > static_cast<uint64_t>(end - cursor))
+					return false;
+
+				values.clear();
+				values.reserve(static_cast<size_t>(size));
+
+				for (uint64_t i = 0; i < size; ++i)
+				{
+					T value;
+
+					if (!Serializer<T>::read(cursor, end, value))
+						return false;
+
+					values.push_back(std::move(value));
+				}
+
+				return true;
+			}
+		};
+
+		template<typename T, int base>
+		struct Serializer<NumericalBase<T, base>>
+		{
+			static constexpr bool Supported = Serializer<T>::Supported;
+
+			static void write(std::string& blob, const NumericalBase<T, base>& wrapper)
+			{
+				Serializer<T>::write(blob, wrapper.value);
+			}
+
+			static bool read(const char*& cursor, const char* end, NumericalBase<T, base>& wrapper)
+			{
+				return Serializer<T>::read(cursor, end, wrapper.value);
+			}
+		};
+
+		template<unsigned int checks>
+		struct Serializer<BasicPath<checks>>
+		{
+			static constexpr bool Supported = true;
+
+			static void write(std::string& blob, const BasicPath<checks>& path)
+			{
+				Serializer<std::string>::write(blob, path.value);
+			}
+
+			static bool read(const char*& cursor, const char* end, BasicPath<checks>& path)
+			{
+				return Serializer<std::string>::read(cursor, end, path.value);
+			}
+		};
+
+		template<typename T>
+		class CmdFunction final : public CmdBase {
+		public:
+			explicit CmdFunction(StringPool& pool, const std::string& name, const std::string& alternative, const std::string& description, bool required, bool dominant)
+				:	CmdBase(pool, name, alternative, description, required, dominant, ArgumentCountChecker<T>::Variadic)
+			{
+			}
+
+			CmdFunction(const CmdFunction& other)
+				:	CmdBase(other)
+				,	callback(other.callback)
+				,	value(other.value)
+			{
+				reset();
+			}
+
+			virtual CmdBase* clone() const override
+			{
+				return new CmdFunction(*this);
+			}
+
+			virtual bool parse(std::ostream& output, std::ostream& error)
+			{
+				try
+				{
+					CallbackArgs args { arguments, output, error };
+					value = callback(args);
+					return true;
+				}
+				catch(const std::exception& e)
+				{
+					error << "ERROR: Failed parsing function's arguments: " << std::endl;
+					
+					for(const auto& a : arguments)
+						error << a << ", " << std::endl;
+
+					error << e.what() << std::endl;
+					// error << Parser::print_help();
+
+					return false;
+				}
+			}
+
+			virtual bool validate(std::ostream& output, std::ostream& error) override
+			{
+				return true;
+			}
+
+			virtual std::string print_value() const
+			{
+				return "";
+			}
+
+			/// A callback that is not called again leaves no result behind.
+			virtual void reset() override
+			{
+				CmdBase::reset();
+				restore();
+			}
+
+			virtual void restore() override
+			{
+				value = T { };
+			}
+
+			virtual size_t memory_usage() const override
+			{
+				return sizeof(*this) + base_memory_usage() + Parser::heap_size(value);
+			}
+
+			virtual bool store(std::string& blob) const override
+			{
+				Serializer<T>::write(blob, value);
+				return Serializer<T>::Supported;
+			}
+
+			virtual bool load(const char*& cursor, const char* end) override
+			{
+				return Serializer<T>::read(cursor, end, value);
+			}
+
+			std::function<T(CallbackArgs&)> callback;
+			T value { };
+		};
+
+		/// A command whose value is published to the parser's LiveState once validated, such
+		/// that it can be read (and changed) while the program runs.
+		template<typename T>
+		class CmdLive final : public CmdBase {
+		public:
+			explicit CmdLive(StringPool& pool, const std::string& name, const std::string& alternative, const std::string& description, const T& initial, std::shared_ptr<LiveState> live, ValidationFunction<T> vf)
+				:	CmdBase(pool, name, alternative, description, false, false, ArgumentCountChecker<T>::Variadic)
+				,	initial(initial)
+				,	live(std::move(live))
+				,	index(this->live->add(std::make_shared<const T>(initial)))
+				,	atomic(make_atomic(initial, typename IsLiveAtomic<T>::type()))
+				,	valFun(std::move(vf))
+				,	fallback(initial)
+			{
+				runtime = true;
+				eager = true;
+				flag = std::is_same<T, bool>::value;
+			}
+
+			virtual bool parse(std::ostream& /*output*/, std::ostream& error)
+			{
+				try
+				{
+					staged = Parser::parse_live(arguments, initial);
+					return true;
+				}
+				catch(const std::exception& e)
+				{
+					error << "ERROR: Parsing '" << name() << "' command arguments: ";
+
+					for(const auto& a : arguments)
+						error << a << ", " << std::endl;
+
+					error << e.what() << std::endl;
+					return false;
+				}
+			}
+
+			virtual bool validate(std::ostream& output, std::ostream& error) override
+			{
+				return Parser::check(staged, error) && (!valFun || valFun(staged, output, error));
+			}
+
+			/// Publishes the value of a run (or a snapshot), which restore falls back to.
+			virtual bool publish() override
+			{
+				fallback = staged;
+				live->publish({ change() });
+				return true;
+			}
+
+			virtual void stage(std::vector<LiveChange>& changes) const override
+			{
+				changes.push_back(change());
+			}
+
+			/// Stages the value of the last run, or the declared default if it was not given to
+			/// any run. The published value stays until the next publish.
+			virtual void restore() override
+			{
+				staged = fallback;
+			}
+
+			LiveChange change() const
+			{
+				auto value = std::make_shared<const T>(staged);
+				return LiveChange { index, value, apply(value, typename IsLiveAtomic<T>::type()) };
+			}
+
+			std::function<void()> apply(const std::shared_ptr<const T>& value, std::true_type) const
+			{
+				auto target = atomic;
+				return [target, value]() { target->store(*value); };
+			}
+
+			std::function<void()> apply(const std::shared_ptr<const T>& /*value*/, std::false_type) const
+			{
+				return nullptr;
+			}
+
+			static std::shared_ptr<LiveAtomic<T>> make_atomic(const T& value, std::true_type)
+			{
+				return std::make_shared<LiveAtomic<T>>(value);
+			}
+
+			static std::shared_ptr<LiveAtomic<T>> make_atomic(const T& /*value*/, std::false_type)
+			{
+				return nullptr;
+			}
+
+			virtual std::string print_value() const
+			{
+				return stringify(live->load<T>(index));
+			}
+
+			virtual size_t memory_usage() const override
+			{
+				return sizeof(*this) + sizeof(T) + base_memory_usage() + Parser::heap_size(initial) + Parser::heap_size(staged) + Parser::heap_size(fallback);
+			}
+
+			virtual bool store(std::string& blob) const override
+			{
+				Serializer<T>::write(blob, live->load<T>(index));
+				return Serializer<T>::Supported;
+			}
+
+			virtual bool load(const char*& cursor, const char* end) override
+			{
+				if (!Serializer<T>::read(cursor, end, staged))
+					return false;
+
+				return publish();
+			}
+
+			T initial;
+			std::shared_ptr<LiveState> live;
+			size_t index;
+			std::shared_ptr<LiveAtomic<T>> atomic;
+			ValidationFunction<T> valFun;
+			T staged;
+			/// The value of the last run, see restore.
+			T fallback;
+		};
+
+		/// A command whose value is written to a variable owned by someone else, e.g. one
+		/// defined by CMDPARSER_GLOBAL.
+		template<typename T>
+		class CmdGlobal final : public CmdBase {
+		public:
+			explicit CmdGlobal(StringPool& pool, const std::string& name, const std::string& alternative, const std::string& description, T* storage)
+				:	CmdBase(pool, name, alternative, description, false, false, ArgumentCountChecker<T>::Variadic)
+				,	storage(storage)
+				,	initial(*storage)
+			{
+				eager = true;
+				flag = std::is_same<T, bool>::value;
+			}
+
+			virtual bool parse(std::ostream& /*output*/, std::ostream& error)
+			{
+				try
+				{
+					staged = Parser::parse(arguments, initial);
+					return true;
+				}
+				catch(const std::exception& e)
+				{
+					error << "ERROR: Parsing '" << name() << "' command arguments: ";
+
+					for(const auto& a : arguments)
+						error << a << ", " << std::endl;
+
+					error << e.what() << std::endl;
+					return false;
+				}
+			}
+
+			virtual bool validate(std::ostream& /*output*/, std::ostream& error) override
+			{
+				return Parser::check(staged, error);
+			}
+
+			virtual bool publish() override
+			{
+				*storage = staged;
+				written = true;
+				return true;
+			}
+
+			/// The variable is only put back if the parser changed it, such that parsers that
+			/// are not given the option leave it alone.
+			virtual void reset() override
+			{
+				CmdBase::reset();
+
+				if (written)
+				{
+					*storage = initial;
+					written = false;
+				}
+			}
+
+			virtual std::string print_value() const
+			{
+				return stringify(*storage);
+			}
+
+			virtual size_t memory_usage() const override
+			{
+				return sizeof(*this) + base_memory_usage() + Parser::heap_size(initial) + Parser::heap_size(staged);
+			}
+
+			virtual bool store(std::string& blob) const override
+			{
+				Serializer<T>::write(blob, *storage);
+				return Serializer<T>::Supported;
+			}
+
+			virtual bool load(const char*& cursor, const char* end) override
+			{
+				if (!Serializer<T>::read(cursor, end, *storage))
+					return false;
+
+				written = true;
+				return true;
+			}
+
+			T* storage;
+			T initial;
+			T staged;
+			bool written = false;
+		};
+
+		/// A variadic command handing each of its elements to a consumer as soon as it is
+		/// encountered, instead of collecting them.
+		template<typename T>
+		class CmdStream final : public CmdBase {
+		public:
+			explicit CmdStream(StringPool& pool, const std::string& name, const std::string& alternative, const std::string& description, ConsumerFunction<T> consumer, ValidationFunction<T> vf)
+				:	CmdBase(pool, name, alternative, description, false, false, true)
+				,	consumer(std::move(consumer))
+				,	valFun(std::move(vf))
+				,	buffer(1)
+			{
+			}
+
+			virtual bool accept(std::string&& argument, std::ostream& output, std::ostream& error) override
+			{
+				T element;
+				buffer[0] = std::move(argument);
+
+				try
+				{
+					element = Parser::parse(buffer, element);
+				}
+				catch(const std::exception& e)
+				{
+					error << "ERROR: Parsing '" << name() << "' command arguments: " << buffer[0] << ", " << std::endl;
+					error << e.what() << std::endl;
+					return false;
+				}
+
+				if (!Parser::check(element, error) || (valFun != nullptr && !valFun(element, output, error)))
+					return false;
+
+				return consumer(std::move(element), output, error);
+			}
+
+			virtual bool parse(std::ostream& /*output*/, std::ostream& /*error*/) override
+			{
+				return true;
+			}
+
+			virtual bool validate(std::ostream& /*output*/, std::ostream& /*error*/) override
+			{
+				return true;
+			}
+
+			virtual std::string print_value() const override
+			{
+				return "";
+			}
+
+			virtual size_t memory_usage() const override
+			{
+				return sizeof(*this) + base_memory_usage() + Parser::heap_size(buffer);
+			}
+
+			ConsumerFunction<T> consumer;
+			ValidationFunction<T> valFun;
+			std::vector<std::string> buffer;
+		};
+
+		template<typename T>
+		class CmdArgument final : public CmdBase {
+		public:
+			explicit CmdArgument(StringPool& pool, const std::string& name, const std::string& alternative, const std::string& description, bool required, bool dominant, ValidationFunction<T> vf = nullptr)
+				:	CmdBase(pool, name, alternative, description, required, dominant, ArgumentCountChecker<T>::Variadic)
+				,	valFun(std::move(vf))
+			{
+				flag = std::is_same<T, bool>::value;
+			}
+
+			CmdArgument(const CmdArgument& other)
+				:	CmdBase(other)
+				,	value(other.initial() != nullptr ? *other.initial() : other.value)
+				,	valFun(other.valFun)
+			{
+				reset();
+			}
+
+			virtual CmdBase* clone() const override
+			{
+				return new CmdArgument(*this);
+			}
+
+			virtual bool parse(std::ostream& output, std::ostream& error)
+			{
+				try
+				{
+					auto result = convert(arguments, value);
+
+					// Keep the default for later runs, it is about to be replaced.
+					keep_initial();
+					value = std::move(result);
+
+					// The tokens are not needed anymore once converted.
+					std::vector<std::string>().swap(arguments);
+					return true;
+				}
+				catch(const std::exception& e)
+				{
+					if(!*command)
+						error << "ERROR: Parsing 'default' command arguments: ";
+					else
+						error << "ERROR: Parsing '" << name() << "' command arguments: ";
+
+					if(arguments.empty())
+					{
+						error << "no arguments provided";
+					}
+					else
+					{
+						for(const auto& a : arguments)
+							error << a << ", " << std::endl;
+					}
+
+					error << e.what() << std::endl;					
+
+					return false;
+				}
+			}
+
+			virtual void reset() override
+			{
+				CmdBase::reset();
+				restore();
+			}
+
+			virtual void restore() override
+			{
+				if (initial() != nullptr)
+					value = *initial();
+			}
+
+			virtual bool store(std::string& blob) const override
+			{
+				Serializer<T>::write(blob, value);
+				return Serializer<T>::Supported;
+			}
+
+			virtual bool load(const char*& cursor, const char* end) override
+			{
+				T loaded;
+
+				if (!Serializer<T>::read(cursor, end, loaded))
+					return false;
+
+				keep_initial();
+				value = std::move(loaded);
+				return true;
+			}
+
+			virtual void use_conversion_cache(ConversionCounters* counters) override
+			{
+				if (counters == nullptr && state == nullptr)
+					return;
+
+				auto& extra = extension();
+				extra.conversions = counters;
+				extra.cache.reset(counters != nullptr ? new ConversionCache<typename ConvertedToken<T>::Type>() : nullptr);
+			}
+
+			/// Converts a single token, taking known tokens from the conversion cache.
+			template<typename U>
+			U convert(std::vector<std::string>& elements, const U& defval)
+			{
+				if (state == nullptr || state->cache == nullptr || elements.size() != 1)
+					return Parser::parse(elements, defval);
+
+				const auto& cache = state->cache;
+				const auto conversions = state->conversions;
+
+				if (auto known = cache->find(elements[0]))
+				{
+					++conversions->hits;
+					return *known;
+				}
+
+				// Strings and paths are moved out of the token, hence the key has to be copied first.
+				++conversions->misses;
+				const std::string token = elements[0];
+				U converted = Parser::parse(elements, defval);
+				cache->insert(token, converted);
+				return converted;
+			}
+
+			/// Converts the elements of a list one by one, taking known tokens from the conversion cache.
+			template<typename E>
+			std::vector<E> convert(std::vector<std::string>& elements, const std::vector<E>& defval)
+			{
+				if (state == nullptr || state->cache == nullptr)
+					return Parser::parse(elements, defval);
+
+				const auto& cache = state->cache;
+				const auto conversions = state->conversions;
+
+				std::vector<E> values { };
+				std::vector<std::string> buffer(1);
+				const E element { };
+				values.reserve(elements.size());
+
+				for (auto& token : elements)
+				{
+					if (auto known = cache->find(token))
+					{
+						++conversions->hits;
+						values.push_back(*known);
+						continue;
+					}
+
+					++conversions->misses;
+					buffer[0] = token;
+					values.push_back(Parser::parse(buffer, element));
+					cache->insert(token, values.back());
+				}
+
+				return values;
+			}
+
+			virtual bool validate(std::ostream& output, std::ostream& error) override
+			{
+				if(!Parser::check(value, error))
+					return false;
+
+				if(valFun != nullptr)
+					return valFun(value, output, error);
+
+				return true;
+			}
+
+			virtual std::string print_value() const
+			{
+				return stringify(value);
+			}
+
+			virtual size_t memory_usage() const override
+			{
+				return sizeof(*this) + base_memory_usage() + Parser::heap_size(value) + (state != nullptr ? sizeof(State) + Parser::heap_size(state->initial) : 0);
+			}
+
+			/// The default, once replaced by a converted value, or null.
+			const T* initial() const
+			{
+				return state != nullptr && state->kept ? &state->initial : nullptr;
+			}
+
+			void keep_initial()
+			{
+				auto& extra = extension();
+
+				if (!extra.kept)
+				{
+					extra.initial = std::move(value);
+					extra.kept = true;
+				}
+			}
+
+			/// What only options that have been given or whose conversions are cached need. It is
+			/// allocated on first use, such that other options stay small.
+			struct State
+			{
+				T initial { };
+				bool kept = false;
+				std::unique_ptr<ConversionCache<typename ConvertedToken<T>::Type>> cache;
+				ConversionCounters* conversions = nullptr;
+			};
+
+			State& extension()
+			{
+				if (state == nullptr)
+					state.reset(new State());
+
+				return *state;
+			}
+
+			T value;
+			ValidationFunction<T> valFun = nullptr;
+			std::unique_ptr<State> state;
+		};
+
+
+
+		static int parse(const std::vector<std::string>& elements, const int&, int numberBase = 0)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stoi(elements[0], 0, numberBase);
+		}
+
+		static bool parse(const std::vector<std::string>& elements, const bool& defval)
+		{
+			if (elements.size() != 0)
+				throw std::runtime_error("A boolean command line parameter cannot have any arguments.");
+
+			return !defval;
+		}
+
+		template<typename T>
+		static T parse_live(const std::vector<std::string>& elements, const T& defval)
+		{
+			return parse(elements, defval);
+		}
+
+		/// Live flags take an explicit value when changed at runtime, e.g. by "set verbose false".
+		static bool parse_live(const std::vector<std::string>& elements, const bool& defval)
+		{
+			if (elements.size() != 1)
+				return parse(elements, defval);
+
+			const auto& value = elements.front();
+
+			if (value == "true" || value == "1")
+				return true;
+
+			if (value == "false" || value == "0")
+				return false;
+
+			throw std::runtime_error("A boolean value has to be true, false, 1 or 0.");
+		}
+
+		static double parse(const std::vector<std::string>& elements, const double&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stod(elements[0]);
+		}
+
+		static float parse(const std::vector<std::string>& elements, const float&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stof(elements[0]);
+		}
+
+		static long double parse(const std::vector<std::string>& elements, const long double&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stold(elements[0]);
+		}
+
+		static unsigned int parse(const std::vector<std::string>& elements, const unsigned int&, int numberBase = 0)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return static_cast<unsigned int>(std::stoul(elements[0], 0, numberBase));
+		}
+
+		static unsigned long parse(const std::vector<std::string>& elements, const unsigned long&, int numberBase = 0)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stoul(elements[0], 0, numberBase);
+		}
+
+		static unsigned long long parse(const std::vector<std::string>& elements, const unsigned long long&, int numberBase = 0)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stoull(elements[0], 0, numberBase);
+		}
+
+		static long long parse(const std::vector<std::string>& elements, const long long&, int numberBase = 0)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stoll(elements[0], 0, numberBase);
+		}
+
+		static long parse(const std::vector<std::string>& elements, const long&, int numberBase = 0)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::stol(elements[0], 0, numberBase);
+		}
+
+		static std::string parse(const std::vector<std::string>& elements, const std::string&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return elements[0];
+		}
+
+		/// Takes over the token, which is not needed anymore after parsing.
+		static std::string parse(std::vector<std::string>& elements, const std::string&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return std::move(elements[0]);
+		}
+
+		static std::vector<std::string> parse(std::vector<std::string>& elements, const std::vector<std::string>&)
+		{
+			std::vector<std::string> values { };
+			values.swap(elements);
+			return values;
+		}
+
+		template<class T>
+		static std::vector<T> parse(const std::vector<std::string>& elements, const std::vector<T>&)
+		{
+			const T defval = T();
+			std::vector<T> values { };
+			std::vector<std::string> buffer(1);
+
+			for (const auto& element : elements)
+			{
+				buffer[0] = element;
+				values.push_back(parse(buffer, defval));
+			}
+
+			return values;
+		}
+
+		template <unsigned int checks> static BasicPath<checks> parse(std::vector<std::string>& elements, const BasicPath<checks>&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return BasicPath<checks>(std::move(elements[0]));
+		}
+
+		template <unsigned int checks> static BasicPath<checks> parse(const std::vector<std::string>& elements, const BasicPath<checks>&)
+		{
+			if (elements.size() != 1)
+				throw std::bad_cast();
+
+			return BasicPath<checks>(elements[0]);
+		}
+
+		template <typename T> static T parse(const std::vector<std::string>& elements, const NumericalBase<T>& wrapper)
+		{
+			return parse(elements, wrapper.value, 0);
+		}
+
+		/// Specialization for number wrapped into numerical base
+		/// \tparam T base type of the argument
+		/// \tparam base numerical base
+		/// \param elements
+		/// \param wrapper
+		/// \return parsed number
+		template <typename T, int base> static T parse(const std::vector<std::string>& elements, const NumericalBase<T, base>& wrapper)
+		{
+			return parse(elements, wrapper.value, wrapper.base);
+		}
+
+		template<class T>
+		static std::string stringify(const T& value)
+		{
+			return std::to_string(value);
+		}
+
+		template<class T, int base>
+		static std::string stringify(const NumericalBase<T, base>& wrapper)
+		{
+			return std::to_string(wrapper.value);
+		}
+
+		template<class T>
+		static std::string stringify(const std::vector<T>& values)
+		{
+			std::stringstream ss { };
+			ss << "[ ";
+
+			for (const auto& value : values)
+			{
+				ss << stringify(value) << " ";
+			}
+
+			ss << "]";
+			return ss.str();
+		}
+
+		static std::string stringify(const std::string& str)
+		{
+			return str;
+		}
+
+		template<unsigned int checks>
+		static std::string stringify(const BasicPath<checks>& path)
+		{
+			return path.value;
+		}
+
+		/// Built-in validation of a value, performed before the validation function is called.
+		template<class T>
+		static bool check(const T&, std::ostream&)
+		{
+			return true;
+		}
+
+		template<unsigned int checks>
+		static bool check(const BasicPath<checks>& path, std::ostream& error)
+		{
+			return check_paths({ &path.value }, checks, error);
+		}
+
+		template<unsigned int checks>
+		static bool check(const std::vector<BasicPath<checks>>& paths, std::ostream& error)
+		{
+			std::vector<const std::string*> values { };
+
+			for (const auto& path : paths)
+				values.push_back(&path.value);
+
+			return check_paths(values, checks, error);
+		}
+
+		/// Checks a single path, returning an error message if it does not pass.
+		static std::string check_path(const std::string& path, unsigned int checks)
+		{
+#if defined(_WIN32)
+			struct _stat64 info;
+			const auto exists = [&info](const std::string& p) { return _stat64(p.c_str(), &info) == 0; };
+			const auto accessible = [](const std::string& p, int mode) { return _access(p.c_str(), mode) == 0; };
+			const auto directory = [&info]() { return (info.st_mode & _S_IFDIR) != 0; };
+			const int readable = 4, writable = 2;
+#else
+			struct stat info;
+			const auto exists = [&info](const std::string& p) { return stat(p.c_str(), &info) == 0; };
+			const auto accessible = [](const std::string& p, int mode) { return access(p.c_str(), mode) == 0; };
+			const auto directory = [&info]() { return S_ISDIR(info.st_mode); };
+			const int readable = R_OK, writable = W_OK;
+#endif
+			if ((checks & (PathCheck::Exists | PathCheck::Readable | PathCheck::Directory)) != 0 && !exists(path))
+				return "ERROR: The path '" + path + "' does not exist.";
+
+			if ((checks & PathCheck::Directory) != 0 && !directory())
+				return "ERROR: The path '" + path + "' is not a directory.";
+
+			if ((checks & PathCheck::Readable) != 0 && !accessible(path, readable))
+				return "ERROR: The path '" + path + "' is not readable.";
+
+			if ((checks & PathCheck::WritableParent) != 0)
+			{
+				const auto separator = path.find_last_of("/\\");
+				const auto parent = separator == std::string::npos ? std::string(".") : path.substr(0, separator + 1);
+
+				if (!exists(parent) || !directory() || !accessible(parent, writable))
+					return "ERROR: The directory of the path '" + path + "' is not writable.";
+			}
+
+			return "";
+		}
+
+		/// The number of threads for tasks that mostly wait for I/O: a few per core, such that the
+		/// cores stay busy while most threads are blocked, but bounded on large machines.
+		static unsigned int io_threads()
+		{
+			return std::min(64u, 4 * std::max(1u, std::thread::hardware_concurrency()));
+		}
+
+		/// Threads the path checks may start in addition to the calling ones. They are shared
+		/// by all checks of the process, e.g. of several lists validated in parallel, such that
+		/// at most io_threads are started for them at any time.
+		class IoThreads
+		{
+		public:
+			/// Takes up to the wanted number of threads, possibly none.
+			explicit IoThreads(size_t wanted) : _count(0)
+			{
+				auto available = spare().load();
+
+				do
+					_count = static_cast<unsigned int>(std::min<size_t>(wanted, available));
+				while (_count > 0 && !spare().compare_exchange_weak(available, available - _count));
+			}
+
+			~IoThreads()
+			{
+				spare() += _count;
+			}
+
+			IoThreads(const IoThreads&) = delete;
+			IoThreads& operator=(const IoThreads&) = delete;
+
+			unsigned int count() const
+			{
+				return _count;
+			}
+
+		private:
+			static std::atomic<unsigned int>& spare()
+			{
+				static std::atomic<unsigned int> threads(io_threads());
+				return threads;
+			}
+
+			unsigned int _count;
+		};
+
+		/// Checks all paths at once. Since the checks mostly wait for the file system, they
+		/// are spread over many threads, such that a batch takes about as long as a single check.
+		/// The calling thread takes part, hence the checks go on if no other thread is left.
+		static bool check_paths(const std::vector<const std::string*>& paths, unsigned int checks, std::ostream& error)
+		{
+			std::vector<std::string> messages(paths.size());
+			const IoThreads threads(paths.size() > 1 ? paths.size() - 1 : 0);
+			parallel_for(paths.size(), threads.count() + 1, [&](size_t i) {
+				messages[i] = check_path(*paths[i], checks);
+			});
+
+			auto valid = true;
+
+			for (const auto& message : messages)
+			{
+				if (!message.empty())
+				{
+					error << message << std::endl;
+					valid = false;
+				}
+			}
+
+			return valid;
+		}
+
+		/// Bytes allocated on the heap by a value, excluding the value itself.
+		template<class T>
+		static size_t heap_size(const T&)
+		{
+			return 0;
+		}
+
+		template<unsigned int checks>
+		static size_t heap_size(const BasicPath<checks>& path)
+		{
+			return heap_size(path.value);
+		}
+
+		static size_t heap_size(const std::string& str)
+		{
+			// Short strings live inside the object itself.
+			const auto data = str.data();
+			const auto self = reinterpret_cast<const char*>(&str);
+			return data >= self && data < self + sizeof(str) ? 0 : str.capacity() + 1;
+		}
+
+		template<class T>
+		static size_t heap_size(const std::vector<T>& values)
+		{
+			size_t bytes = values.capacity() * sizeof(T);
+
+			for (const auto& value : values)
+				bytes += heap_size(value);
+
+			return bytes;
+		}
+
+	public:
+		explicit Parser(int argc, const char** argv)
+		{
+			init(argc, argv);
+		}
+
+		explicit Parser(int argc, char** argv)
+		{
+			init(argc, argv);
+		}
+
+		
+		Parser(int argc, const char** argv, std::string generalProgramDescriptionForHelpText)
+			:	_general_help_text(std::move(generalProgramDescriptionForHelpText))
+		{
+			init(argc, argv);
+		}
+
+		Parser(int argc, char** argv, std::string generalProgramDescriptionForHelpText)
+			:	_general_help_text(std::move(generalProgramDescriptionForHelpText))
+		{
+			init(argc, argv);
+		}
+
+		
+		Parser()
+		{			
+		}
+		
+		Parser(std::string generalProgramDescriptionForHelpText)
+			:	_general_help_text(std::move(generalProgramDescriptionForHelpText))
+		{			
+		}
+		
+		/// The options, the string pool they point into and the threads serving live options
+		/// belong to a single parser, hence it cannot be copied.
+		Parser(const Parser&) = delete;
+		Parser& operator=(const Parser&) = delete;
+
+
+		~Parser()
+		{
+#if defined(__linux__)
+			_admin.reset();
+			_watcher.reset();
+#endif
+
+			for (size_t i = 0, n = _commands.size(); i < n; ++i)
+			{
+				delete _commands[i];
+			}
+		}
+		
+		
+		void init(int argc, char** argv)
+		{
+			init(argc, const_cast<const char**>(argv));
+		}
+		
+		void init(int argc, const char** argv)
+		{
+			_appname = argc > 0 ? argv[0] : "";
+			assign(argv + 1, argc > 1 ? static_cast<size_t>(argc - 1) : 0);
+			enable_help();
+		}
+
+		/// Like init, but the arguments are not copied: argv has to stay valid and unchanged
+		/// while the parser is used, as the one passed to main does. Forwarded arguments
+		/// then point into argv. The integrated help is only added if it is missing.
+		void borrow(int argc, char** argv)
+		{
+			borrow(argc, const_cast<const char**>(argv));
+		}
+
+		void borrow(int argc, const char** argv)
+		{
+			_appname = argc > 0 ? argv[0] : "";
+			point(argv + 1, argc > 1 ? static_cast<size_t>(argc - 1) : 0);
+
+			if (!has_help())
+				enable_help();
+		}
+
+		
+		bool has_help() const
+		{
+			for (const auto& command : _commands)
+			{
+				if (is_help(command))
+					return true;
+			}
+
+			return false;
+		}
+
+		void enable_help()
+		{
+			set_callback(
+				"h",
+				"help",
+				std::function<bool(CallbackArgs&)>
+				(
+					[this](CallbackArgs& args)
+					{
+						if (_static_usage != nullptr)
+							this->print_static_usage(args.output);
+						else
+							args.output << this->usage();
+						// #pragma warning(push)
+						// #pragma warning(disable: 4702)
+						// exit(0);
+						return false;
+						// #pragma warning(pop)
+					}
+				),
+				"",
+				true
+			);
+			_commands.back()->terminating = true;
+		}
+
+		/// Marks a dominant option, e.g. --version, to end the parsing once encountered. The
+		/// remaining arguments are ignored, no other option is converted and run returns false.
+		/// Such options cannot take arguments. The integrated help is terminating by default.
+		void set_terminating(const std::string& name, bool terminating = true)
+		{
+			command_of(name)->terminating = terminating;
+		}
+
+		/// Marks the validator (or callback) of an option as independent of all others and of the
+		/// application's state, so it may run concurrently with parallel validation.
+		void set_independent(const std::string& name, bool independent = true)
+		{
+			command_of(name)->independent = independent;
+		}
+
+		/// Marks the validator of an option as pure, i.e. its outcome only depends on the
+		/// arguments of the option. Such validators are not run again for the same arguments
+		/// while the validation cache is enabled.
+		void set_pure(const std::string& name, bool pure = true)
+		{
+			command_of(name)->pure = pure;
+		}
+
+		/// Caches the outcome of pure validators across runs, e.g. when the parser is reused
+		/// for many command lines via run_line. Entries expire after the given time.
+		void enable_validation_cache(size_t capacity = 1024, std::chrono::steady_clock::duration ttl = std::chrono::minutes(1))
+		{
+			_validation_cache.reset(new ValidationCache(capacity, ttl));
+		}
+
+		void disable_validation_cache()
+		{
+			_validation_cache.reset();
+		}
+
+		CacheStatistics validation_cache_statistics() const
+		{
+			return _validation_cache != nullptr ? _validation_cache->statistics() : CacheStatistics { 0, 0 };
+		}
+
+		/// Remembers the values tokens have been converted to, such that repeated tokens (in
+		/// lists or across runs) are converted only once. The cache lives until it is cleared,
+		/// e.g. at the end of a batch of command lines.
+		void enable_conversion_cache()
+		{
+			_conversions.reset(new ConversionCounters());
+			_conversions->hits = 0;
+			_conversions->misses = 0;
+			clear_conversion_cache();
+		}
+
+		void disable_conversion_cache()
+		{
+			_conversions.reset();
+			clear_conversion_cache();
+		}
+
+		void clear_conversion_cache()
+		{
+			for (auto command : _commands)
+				command->use_conversion_cache(_conversions.get());
+		}
+
+		CacheStatistics conversion_cache_statistics() const
+		{
+			return _conversions != nullptr ? CacheStatistics { _conversions->hits, _conversions->misses } : CacheStatistics { 0, 0 };
+		}
+
+		/// Runs the validators marked as independent on up to the given number of threads. By
+		/// default (0) four threads per core are used, at most 64, since validators usually wait
+		/// for I/O. Their output is buffered and written in declaration order.
+		void enable_parallel_validation(unsigned int threads = 0)
+		{
+			_threads = threads == 0 ? io_threads() : threads;
+		}
+
+		void disable_parallel_validation()
+		{
+			_threads = 1;
+		}
+
+		/// Uses a usage text assembled at compile time (see CMDPARSER_USAGE_*) for the
+		/// integrated help, instead of generating it from the registered options.
+		template<size_t N>
+		void set_static_usage(const char (&usage)[N])
+		{
+			_static_usage = usage;
+			_static_usage_size = N - 1;
+		}
+
+		/// Checks that the static usage text has an entry for every registered option and
+		/// reports the missing ones. Debug builds check this whenever the help is printed.
+		bool check_static_usage(std::ostream& error) const
+		{
+			const std::string text(_static_usage != nullptr ? _static_usage : "", _static_usage_size);
+			auto valid = true;
+
+			for (const auto command : _commands)
+			{
+				const auto entry = is_default(command) ? std::string("\tDEFAULT\n") : "\t" + std::string(command->command) + ",\t" + command->alternative + "\n";
+
+				if (text.find(entry) == std::string::npos)
+				{
+					error << "ERROR: The static usage text has no entry for '" << command->name() << "'." << std::endl;
+					valid = false;
+				}
+			}
+
+			return valid;
+		}
+
+		void disable_help()
+		{
+			for (auto command = _commands.begin(); command != _commands.end(); ++command)
+			{
+				if (is_help(*command))
+				{
+					_tokens.erase(*command);
+					_failures.erase(*command);
+					delete *command;
+					_commands.erase(command);
+					_index.clear();
+					break;
+				}
+			}
+		}
+
+		template<typename T>
+		void set_default(bool is_required, const std::string& description = "", T defaultValue = T(), ValidationFunction<T> vf = nullptr)
+		{
+			auto command = new CmdArgument<T> { _pool, "", "", description, is_required, false, std::move(vf) };
+			command->value = std::move(defaultValue);
+			add_command(command);
+		}
+
+		template<typename T>
+		void set_required(const std::string& name, const std::string& alternative, const std::string& description = "", ValidationFunction<T> vf = nullptr, bool dominant = false)
+		{
+			auto command = new CmdArgument<T> { _pool, name, alternative, description, true, dominant, std::move(vf) };
+			add_command(command);
+		}
+
+		template<typename T>
+		void set_optional(const std::string& name, const std::string& alternative, T defaultValue, const std::string& description = "", ValidationFunction<T> vf = nullptr, bool dominant = false)
+		{
+			auto command = new CmdArgument<T> { _pool, name, alternative, description, false, dominant, std::move(vf) };
+			command->value = std::move(defaultValue);
+			add_command(command);
+		}
+
+		/// Registers a list option whose elements are converted and handed to the consumer one
+		/// by one while run scans the arguments, so they are never collected in memory.
+		/// Elements are delivered before the remaining arguments are checked.
+		template<typename T>
+		void set_stream(const std::string& name, const std::string& alternative, ConsumerFunction<T> consumer, const std::string& description = "", ValidationFunction<T> vf = nullptr)
+		{
+			auto command = new CmdStream<T> { _pool, name, alternative, description, std::move(consumer), std::move(vf) };
+			add_command(command);
+		}
+
+		/// Registers an optional option whose value can be changed while the program runs. The
+		/// value is read through the returned handle without locking; it is published once it
+		/// has been validated and keeps its value if not given in later runs.
+		template<typename T>
+		Live<T> set_live(const std::string& name, const std::string& alternative, T defaultValue, const std::string& description = "", ValidationFunction<T> vf = nullptr)
+		{
+			auto command = new CmdLive<T> { _pool, name, alternative, description, defaultValue, _live, std::move(vf) };
+			add_command(command);
+			return Live<T>(_live, command->index, command->atomic);
+		}
+
+		/// The current values of all live options, which stay unchanged in the view. Options
+		/// changed together, e.g. by reload, are either all old or all new.
+		LiveView live_view() const
+		{
+			return LiveView(_live->pin());
+		}
+
+		/// Registers an optional option whose value is written to the given variable, which has
+		/// to outlive the parser. Its value when registering is the default.
+		template<typename T>
+		void set_global(const std::string& name, const std::string& alternative, T* storage, const std::string& description = "")
+		{
+			add_command(new CmdGlobal<T> { _pool, name, alternative, description, storage });
+		}
+
+		/// Changes the value of a live option, given by its short or long name, while the program
+		/// runs. The value is split like a command line, converted and validated like by run and
+		/// only published if it is valid; flags take true, false, 1 or 0 and lists all values.
+		bool update(const std::string& name, const std::string& value, std::ostream& output = std::cout, std::ostream& error = std::cerr)
+		{
+			std::lock_guard<std::mutex> lock(_updates);
+			CmdBase* command = nullptr;
+
+			for (auto candidate : _commands)
+			{
+				if (name == candidate->name() || candidate->is("--" + name))
+					command = candidate;
+			}
+
+			if (command == nullptr || !command->runtime)
+			{
+				error << "ERROR: The parameter '" << name << "' cannot be changed at runtime." << std::endl;
+				return false;
+			}
+
+			// The value is split like a command line, so lists take several values.
+			std::string buffer { };
+			std::vector<size_t> offsets { };
+
+			if (!split(value, buffer, offsets, error))
+				return false;
+
+			if (offsets.size() > 1 && !command->variadic)
+			{
+				error << "ERROR: The parameter '" << command->name() << "' takes a single value." << std::endl;
+				return false;
+			}
+
+			command->arguments.clear();
+
+			for (const auto offset : offsets)
+				command->arguments.emplace_back(buffer.data() + offset);
+
+			// An empty value stays an (invalid) argument, a flag is not set by it.
+			if (offsets.empty())
+				command->arguments.emplace_back();
+
+			command->reusable = false;
+
+			if (!command->parse(output, error) || !command->validate(output, error))
+			{
+				error << "ERROR: The parameter '" << command->name() << "' has invalid arguments. Usage:\n";
+				error << command->usage();
+				return false;
+			}
+
+			// Unlike by run, the value is not the one reload falls back to.
+			std::vector<LiveChange> changes { };
+			command->stage(changes);
+			_live->publish(changes);
+			return true;
+		}
+
+		/// Sets the live options given in a configuration file, which contains options like a
+		/// command line (comments are not supported), and the others back to the values of the
+		/// last run, i.e. those given on the command line or else their defaults. The
+		/// values are only published if all of them are valid, otherwise the problems are
+		/// returned and nothing changes.
+		std::vector<Diagnostic> reload(const std::string& path)
+		{
+			std::vector<Diagnostic> diagnostics { };
+			std::ifstream file(path);
+			std::stringstream content { };
+			std::stringstream error { };
+			std::string buffer { };
+			std::vector<size_t> offsets { };
+
+			if (!file)
+			{
+				diagnostics.push_back({ "", "The file '" + path + "' cannot be read." });
+				return diagnostics;
+			}
+
+			content << file.rdbuf();
+
+			if (!split(content.str(), buffer, offsets, error))
+			{
+				diagnostics.push_back({ "", message(error) });
+				return diagnostics;
+			}
+
+			std::lock_guard<std::mutex> lock(_updates);
+			std::vector<CmdBase*> given { };
+			CmdBase* current = nullptr;
+
+			for (const auto offset : offsets)
+			{
+				const std::string token(buffer.data() + offset);
+				const auto associated = token[0] == '-' ? find(token) : nullptr;
+
+				if (associated != nullptr && !associated->runtime)
+				{
+					diagnostics.push_back({ associated->name(), "The parameter cannot be changed at runtime." });
+					current = nullptr;
+				}
+				else if (associated != nullptr && std::find(given.begin(), given.end(), associated) != given.end())
+				{
+					diagnostics.push_back({ associated->name(), "The parameter is given more than once." });
+					current = nullptr;
+				}
+				else if (associated != nullptr)
+				{
+					associated->arguments.clear();
+					associated->reusable = false;
+					given.push_back(associated);
+					current = associated;
+				}
+				else if (current == nullptr || (!current->variadic && !current->arguments.empty()))
+				{
+					diagnostics.push_back({ "", "The argument '" + token + "' is invalid in this context." });
+				}
+				else
+				{
+					current->arguments.push_back(token);
+				}
+			}
+
+			// Stage all values before publishing any of them.
+			for (auto command : given)
+			{
+				std::stringstream output { };
+				error.str("");
+
+				if (!command->parse(output, error) || !command->validate(output, error))
+					diagnostics.push_back({ command->name(), message(error) });
+			}
+
+			// All values are swapped in at once, readers see either the old or the new ones.
+			// Live options missing from the file are set back to the values of the last run.
+			if (diagnostics.empty())
+			{
+				std::vector<LiveChange> changes { };
+
+				for (auto command : _commands)
+				{
+					if (!command->runtime)
+						continue;
+
+					if (std::find(given.begin(), given.end(), command) == given.end())
+						command->restore();
+
+					command->stage(changes);
+				}
+
+				_live->publish(changes);
+			}
+
+			return diagnostics;
+		}
+
+#if defined(__linux__)
+		/// Reloads the configuration file (see reload) whenever it is written or replaced, on a
+		/// thread of its own until unwatch_config is called or the parser is destroyed. The
+		/// listener receives the problems of each reload, i.e. nothing if it succeeded.
+		bool watch_config(const std::string& path, ReloadFunction listener = nullptr, std::ostream& error = std::cerr)
+		{
+			_watcher.reset();
+
+			const auto slash = path.find_last_of('/');
+			const auto directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+			const int inotify = inotify_init1(IN_CLOEXEC);
+
+			// Editors often replace the file, hence its directory is watched.
+			if (inotify < 0 || inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+			{
+				error << "ERROR: Cannot watch '" << path << "': " << std::strerror(errno) << std::endl;
+
+				if (inotify >= 0)
+					::close(inotify);
+
+				return false;
+			}
+
+			std::unique_ptr<ConfigWatcher> watcher(new ConfigWatcher(*this, inotify, path, path.substr(slash == std::string::npos ? 0 : slash + 1), std::move(listener)));
+
+			if (!watcher->start())
+			{
+				error << "ERROR: Cannot watch '" << path << "': " << std::strerror(errno) << std::endl;
+				return false;
+			}
+
+			_watcher = std::move(watcher);
+			return true;
+		}
+
+		void unwatch_config()
+		{
+			_watcher.reset();
+		}
+#endif
+
+		template<typename T>
+		void set_callback(const std::string& name, const std::string& alternative, std::function<T(CallbackArgs&)> callback, const std::string& description = "", bool dominant = false)
+		{
+			auto command = new CmdFunction<T> { _pool, name, alternative, description, false, dominant };
+			command->callback = std::move(callback);
+			add_command(command);
+		}
+
+		inline void run_and_exit_if_error()
+		{
+			if (run() == false)
+			{
+				exit(1);
+			}
+		}
+
+		inline bool run()
+		{
+			return run(std::cout, std::cerr);
+		}
+
+		inline bool run(std::ostream& output)
+		{
+			return run(output, std::cerr);
+		}
+
+		/// Runs the parser on another thread. Independent callbacks and validators of the
+		/// options overlap with each other (see enable_parallel_validation) and with the
+		/// caller, which only has to wait when it needs the result. The streams and the
+		/// parser must stay alive until the result is available.
+		std::future<bool> run_async(std::ostream& output = std::cout, std::ostream& error = std::cerr)
+		{
+			return std::async(std::launch::async, [this, &output, &error]() {
+				return run(output, error);
+			});
+		}
+
+		inline bool run_line(const std::string& line)
+		{
+			return run_line(line, std::cout, std::cerr);
+		}
+
+		/// Splits a command line (without the program name) following the POSIX shell quoting
+		/// rules, i.e. single and double quotes as well as backslash escapes, and runs the
+		/// parser on the resulting arguments.
+		bool run_line(const std::string& line, std::ostream& output, std::ostream& error)
+		{
+			return tokenize(line, error) && run(output, error);
+		}
+
+		/// Checks if -name or altName (given with its dashes) is among the arguments. The
+		/// arguments are hashed when they are given, hence queries neither scan them nor
+		/// change the parser, and may be made from several threads.
+		bool doesArgumentExist(const std::string& name, const std::string& altName) const
+		{
+			return is_present("-", name) || is_present("", altName);
+		}
+
+		/// Runs the parser on a new command line, e.g. a revision of the previous one. Options
+		/// whose arguments are byte-identical to those of the previous run keep their converted
+		/// and validated value (validators and callbacks are not run again, hence their output
+		/// is not repeated); only changed options are processed. Once used, run does the same.
+		/// The arguments are copied.
+		bool reparse(int argc, const char** argv, std::ostream& output = std::cout, std::ostream& error = std::cerr)
+		{
+			assign(argv + 1, argc > 1 ? static_cast<size_t>(argc - 1) : 0);
+			_incremental = true;
+
+			return run(output, error);
+		}
+
+		bool reparse(int argc, char** argv, std::ostream& output = std::cout, std::ostream& error = std::cerr)
+		{
+			return reparse(argc, const_cast<const char**>(argv), output, error);
+		}
+
+		/// Stores the values and the given options of the last run in a binary blob, which
+		/// restore can adopt, e.g. in a child process, without converting or validating the
+		/// arguments again. Options whose type cannot be stored are marked as such, as are
+		/// options whose conversion deferred by the lazy mode fails; restore refuses these if
+		/// they were given, such that the child runs the parser and reports the problem.
+		std::string snapshot()
+		{
+			// Global options are part of the schema, they are added on first use like by run.
+			add_global_options();
+
+			std::string blob { };
+			Serializer<uint32_t>::write(blob, SnapshotMagic);
+			Serializer<uint32_t>::write(blob, SnapshotVersion);
+			Serializer<uint32_t>::write(blob, static_cast<uint32_t>(_commands.size()));
+
+			for (auto command : _commands)
+			{
+				Serializer<std::string>::write(blob, command->name());
+				const auto flags = blob.size();
+				blob.push_back(command->handled ? static_cast<char>(SnapshotHandled) : 0);
+
+				if (settle(command) && command->store(blob))
+					blob[flags] |= static_cast<char>(SnapshotStored);
+			}
+
+			return blob;
+		}
+
+		/// Adopts the state stored by snapshot. Returns false if the snapshot is invalid, was
+		/// created by a different schema or lacks the value of a given option (because its
+		/// type cannot be stored); run has to be used then.
+		bool restore(const char* data, size_t size, std::ostream& error = std::cerr)
+		{
+			add_global_options();
+
+			const char* cursor = data;
+			const char* end = data + size;
+			uint32_t magic = 0, version = 0, count = 0;
+
+			if (!Serializer<uint32_t>::read(cursor, end, magic) || magic != SnapshotMagic
+				|| !Serializer<uint32_t>::read(cursor, end, version) || version != SnapshotVersion
+				|| !Serializer<uint32_t>::read(cursor, end, count) || count != _commands.size())
+			{
+				error << "ERROR: The snapshot was not created by this parser." << std::endl;
+				return false;
+			}
+
+			_forwarded.assign(2, nullptr);
+			_failures.clear();
+
+			for (auto command : _commands)
+			{
+				std::string name { };
+				command->reset();
+
+				if (!Serializer<std::string>::read(cursor, end, name) || name != command->name() || cursor == end)
+				{
+					error << "ERROR: The snapshot was not created by this parser." << std::endl;
+					return false;
+				}
+
+				const auto flags = static_cast<unsigned char>(*cursor++);
+				command->handled = (flags & SnapshotHandled) != 0;
+
+				if ((flags & SnapshotStored) != 0 && !command->load(cursor, end))
+				{
+					error << "ERROR: The snapshot is corrupt." << std::endl;
+					return false;
+				}
+
+				if (command->handled && (flags & SnapshotStored) == 0)
+				{
+					error << "ERROR: The value of '" << command->name() << "' is not part of the snapshot." << std::endl;
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		bool restore(const std::string& blob, std::ostream& error = std::cerr)
+		{
+			return restore(blob.data(), blob.size(), error);
+		}
+
+#if defined(__linux__)
+		/// Writes a snapshot to an anonymous memory file and returns its descriptor (or -1).
+		/// The descriptor is inherited by children, which pass it to restore_from.
+		int export_snapshot()
+		{
+			const auto blob = snapshot();
+			const int fd = memfd_create("cmdparser", 0);
+
+			if (fd < 0)
+				return -1;
+
+			size_t written = 0;
+
+			while (written < blob.size())
+			{
+				const auto result = write(fd, blob.data() + written, blob.size() - written);
+
+				if (result <= 0)
+				{
+					close(fd);
+					return -1;
+				}
+
+				written += static_cast<size_t>(result);
+			}
+
+			return fd;
+		}
+
+		/// Maps the snapshot in the given file and adopts it, see restore.
+		bool restore_from(int fd, std::ostream& error = std::cerr)
+		{
+			struct stat status;
+
+			if (fstat(fd, &status) != 0 || status.st_size <= 0)
+			{
+				error << "ERROR: The snapshot cannot be read." << std::endl;
+				return false;
+			}
+
+			const auto size = static_cast<size_t>(status.st_size);
+			const auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (data == MAP_FAILED)
+			{
+				error << "ERROR: The snapshot cannot be read." << std::endl;
+				return false;
+			}
+
+			const auto restored = restore(static_cast<const char*>(data), size, error);
+			munmap(data, size);
+
+			return restored;
+		}
+
+		/// Serves the live options on a UNIX domain socket at the given path, on a thread of
+		/// its own until stop_admin_socket is called or the parser is destroyed. Requests are
+		/// lines: "list" prints the name and value of each live option, "set <name> <value>"
+		/// updates one. Each response ends with a line "OK" or "ERROR". Fails if another
+		/// process still serves the path.
+		bool start_admin_socket(const std::string& path, std::ostream& error = std::cerr)
+		{
+			_admin.reset();
+
+			sockaddr_un address { };
+			address.sun_family = AF_UNIX;
+
+			if (path.empty() || path.size() >= sizeof(address.sun_path))
+			{
+				error << "ERROR: The socket path '" << path << "' is invalid." << std::endl;
+				return false;
+			}
+
+			std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+			// Remove the socket left behind by a previous instance, but not one that is still served.
+			struct stat info;
+
+			if (stat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+			{
+				const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+				const auto served = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+
+				if (probe >= 0)
+					::close(probe);
+
+				if (served)
+				{
+					error << "ERROR: The socket '" << path << "' is in use." << std::endl;
+					return false;
+				}
+
+				::unlink(path.c_str());
+			}
+
+			const int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+			if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 8) != 0)
+			{
+				error << "ERROR: Cannot listen on '" << path << "': " << std::strerror(errno) << std::endl;
+
+				if (listener >= 0)
+					::close(listener);
+
+				return false;
+			}
+
+			std::unique_ptr<AdminSocket> admin(new AdminSocket(*this, listener, path));
+
+			if (!admin->start())
+			{
+				error << "ERROR: Cannot serve '" << path << "': " << std::strerror(errno) << std::endl;
+				return false;
+			}
+
+			_admin = std::move(admin);
+			return true;
+		}
+
+		void stop_admin_socket()
+		{
+			_admin.reset();
+		}
+#endif
+
+		inline bool doesHelpExist() const
+		{
+			return doesArgumentExist("h", "--help");
+		}
+
+		bool run(std::ostream& output, std::ostream& error)
+		{
+			std::lock_guard<std::mutex> lock(_updates);
+			add_global_options();
+
+			// Completion queries are answered from the name index only, without
+			// converting or validating anything.
+			if (_completion && _argument_count > 0 && std::strcmp(_arguments[0], "--__complete") == 0)
+			{
+				const auto matches = complete(_argument_count > 1 ? _arguments[1] : "");
+
+				for (const auto& match : matches)
+					output << match << '\n';
+
+				return false;
+			}
+
+			_forwarded.assign(2, nullptr);
+			_failures.clear();
+
+			for (auto command : _commands)
+			{
+				if (_incremental)
+					command->rewind();
+				else
+					command->reset();
+			}
+
+			if (!scan(_arguments, _argument_count, [](CmdBase* command) { return command; }, [this](const char* argument) { forward(argument); }, output, error))
+				return false;
+
+			// Options given previously but not anymore fall back to their defaults. The given
+			// ones get their entry for the tokens up front, they may be processed concurrently.
+			if (_incremental)
+			{
+				for (auto command : _commands)
+				{
+					if (command->handled)
+					{
+						_tokens[command];
+					}
+					else
+					{
+						command->reset();
+						_tokens.erase(command);
+					}
+				}
+			}
+
+			// First, parse dominant arguments since they succeed even if required
+			// arguments are missing.
+			for (auto command : _commands)
+			{
+				if (command->handled && command->dominant && !process(command, output, error))
+				{
+					error << "ERROR: The parameter '" << command->name() << "' has invalid arguments. Usage:\n";
+					error << command->usage();
+					return false;
+				}
+			}
+
+			// Next, check for any missing arguments.
+			for (auto command : _commands)
+			{
+				if (command->required && !command->handled)
+				{
+					error << "ERROR: The parameter '" << command->name() << "' is required. Usage:\n";
+					error << command->usage();
+					return false;
+				}
+			}
+
+			// Finally, parse all remaining arguments. In lazy mode this is deferred
+			// until the value is requested for the first time.
+			if (_threads > 1 && !_lazy)
+				return parse_in_parallel(output, error);
+
+			for (auto command : _commands)
+			{
+				if (command->handled && !command->dominant && !command->eager && _lazy)
+					command->pending = true;
+				else if (command->handled && !command->dominant && !process(command, output, error))
+				{
+					error << "ERROR: The parameter '" << command->name() << "' has invalid arguments. Usage:\n";
+					error << command->usage();
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/// Defers converting and validating the (non-dominant) options until their value
+		/// is requested via get for the first time. run only checks the given parameters
+		/// and the presence of required options then. Live and global options are still
+		/// converted by run, since their values are read without the parser. get may be called
+		/// from several threads, the first call for an option converts it once for all.
+		void enable_lazy_parsing()
+		{
+			_lazy = true;
+		}
+
+		void disable_lazy_parsing()
+		{
+			_lazy = false;
+		}
+
+		/// Instead of failing on unknown options, collects them (and the values following them) as
+		/// well as all arguments after "--" for forwarding, e.g. to a child process.
+		void enable_forwarding()
+		{
+			_forwarding = true;
+		}
+
+		void disable_forwarding()
+		{
+			_forwarding = false;
+		}
+
+		/// The arguments collected in forwarding mode, preceded by program as argv[0] and terminated
+		/// by a null pointer, as expected by execv. They point into the parser's copy of the
+		/// arguments, which stays valid until new arguments are given, or into the argv given
+		/// to borrow.
+		const char* const* forwarded_argv(const char* program)
+		{
+			_forwarded.front() = program;
+			return _forwarded.data();
+		}
+
+		/// The number of collected arguments, not counting argv[0].
+		size_t forwarded_count() const
+		{
+			return _forwarded.size() - 2;
+		}
+
+		/// Allows long options to be abbreviated as long as the abbreviation is
+		/// unambiguous, e.g. --verb for --verbose.
+		void enable_abbreviations()
+		{
+			_abbreviations = true;
+		}
+
+		void disable_abbreviations()
+		{
+			_abbreviations = false;
+		}
+
+		/// Adds the options defined by CMDPARSER_GLOBAL in any part of the program, apart from
+		/// shared libraries. They are looked up when run is called for the first time afterwards.
+		void enable_global_options()
+		{
+			_globals = true;
+		}
+
+		/// Also adds the options defined in a shared library, given by the function defined by
+		/// CMDPARSER_GLOBAL_LIBRARY in it. Options found more than once are added once.
+		void enable_global_options(GlobalOptions library)
+		{
+			_globals = true;
+			_globals_added = false;
+			_global_libraries.push_back(library);
+		}
+
+		/// Lets run answer the hidden --__complete <partial> query, see complete.
+		void enable_completion()
+		{
+			_completion = true;
+		}
+
+		void disable_completion()
+		{
+			_completion = false;
+		}
+
+		/// Returns all option names (e.g. "-v" or "--verbose") starting with the given prefix
+		/// \param partial the word typed so far
+		/// \return matching option names in lexicographical order
+		std::vector<std::string> complete(const std::string& partial) const
+		{
+			std::vector<std::string> matches { };
+			const auto range = prefix_range(partial);
+
+			for (auto it = range.first; it != range.second; ++it)
+				matches.push_back(it->name);
+
+			return matches;
+		}
+
+		/// Generates a completion script for the given shell. The option names are embedded in the
+		/// script, so pressing TAB does not need to start the program at all.
+		/// \param shell the shell to generate the script for
+		/// \param program the command to complete, defaults to the name the application was started with
+		std::string completion_script(CompletionShell shell, const std::string& program = "") const
+		{
+			auto command = program.empty() ? _appname.substr(_appname.find_last_of("/\\") + 1) : program;
+			std::string function = "_";
+			std::stringstream ss { };
+
+			for (const auto c : command)
+				function += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+
+			switch (shell)
+			{
+				case CompletionShell::Bash:
+					ss << function << "_complete()\n{\n";
+					ss << "\tlocal cur=\"${COMP_WORDS[COMP_CWORD]}\"\n";
+					ss << "\tCOMPREPLY=( $(compgen -W \"";
+
+					for (const auto& entry : name_index())
+						ss << entry.name << ' ';
+
+					ss << "\" -- \"$cur\") )\n}\n";
+					ss << "complete -o default -F " << function << "_complete " << command << '\n';
+					break;
+
+				case CompletionShell::Zsh:
+					ss << "#compdef " << command << "\n\n";
+					ss << function << "()\n{\n\t_arguments";
+
+					for (const auto cmd : _commands)
+					{
+						if (is_default(cmd))
+							continue;
+
+						const std::string command(cmd->command), alternative(cmd->alternative);
+						const auto names = command.empty() || alternative.empty()
+							?	command + alternative
+							:	"'(" + command + " " + alternative + ")'{" + command + "," + alternative + "}";
+						std::string description { };
+
+						for (auto c = cmd->description; *c; ++c)
+						{
+							if (*c == '[' || *c == ']' || *c == ':' || *c == '\\')
+								description += '\\';
+
+							description += *c == '\'' ? std::string("'\\''") : std::string(1, *c);
+						}
+
+						ss << " \\\n\t\t" << names << "'[" << description << "]'";
+					}
+
+					ss << "\n}\n\n" << function << " \"$@\"\n";
+					break;
+
+				case CompletionShell::Fish:
+					for (const auto cmd : _commands)
+					{
+						if (is_default(cmd))
+							continue;
+
+						ss << "complete -c " << command;
+
+						if (std::strlen(cmd->command) == 2)
+							ss << " -s " << cmd->name();
+						else if (*cmd->command)
+							ss << " -o " << cmd->name();
+
+						if (*cmd->alternative)
+							ss << " -l " << cmd->alternative + 2;
+
+						if (*cmd->description)
+						{
+							ss << " -d '";
+
+							for (auto c = cmd->description; *c; ++c)
+							{
+								if (*c == '\'' || *c == '\\')
+									ss << '\\';
+
+								ss << *c;
+							}
+
+							ss << '\'';
+						}
+
+						ss << '\n';
+					}
+					break;
+			}
+
+			return ss.str();
+		}
+
+		template<typename T>
+		T get(const std::string& name) const
+		{
+			const auto command = command_of(name);
+
+			if (auto live = dynamic_cast<CmdLive<T>*>(command))
+				return live->live->template load<T>(live->index);
+
+			return value_of<T>(command);
+		}
+
+		template<typename T>
+		T get_default()
+		{
+			return get<T>("");
+		}
+
+		template<typename T>
+		T get_if(const std::string& name, std::function<T(T)> callback) const
+		{
+			return callback(get<T>(name));
+		}
+
+		/// Like get, but returns a reference to the stored value instead of a copy. For global
+		/// options this is their variable; live options cannot be referenced since their value
+		/// may be replaced at any time, get or their handle copy it.
+		template<typename T>
+		const T& get_ref(const std::string& name) const
+		{
+			return value_of<T>(name);
+		}
+
+		/// Moves the value out of the parser. Subsequent calls to get return a moved-from value
+		/// until the option is converted again, also by a reparse with the same arguments.
+		/// The values of live and global options cannot be taken.
+		template<typename T>
+		T take(const std::string& name)
+		{
+			auto command = command_of(name);
+
+			if (dynamic_cast<CmdGlobal<T>*>(command))
+				throw std::runtime_error("The value of the global parameter " + std::string(command->name()) + " belongs to its variable and cannot be taken.");
+
+			auto& value = value_of<T>(command);
+			command->reusable = false;
+
+			return std::move(value);
+		}
+
+		/// Options given on top of a parsed parser (or of another overlay), e.g. the arguments
+		/// of a single task on top of a shared base configuration. Only the given options are
+		/// copied, all others are read from the layers below. An overlay keeps the layers below
+		/// alive, hence overlays can be moved freely, e.g. into a container; the parser has to
+		/// outlive them, and neither it nor the layers below must be run again meanwhile.
+		class Overlay
+		{
+		public:
+			Overlay(Overlay&&) = default;
+			Overlay& operator=(Overlay&&) = default;
+
+			/// Parses and validates the given tokens (without the program name) like run does.
+			/// Dominant options cannot be overridden and required options need not be given again.
+			bool run(const std::vector<std::string>& tokens, std::ostream& output = std::cout, std::ostream& error = std::cerr)
+			{
+				auto& overrides = _layer->overrides;
+				auto& forwarded = _layer->forwarded;
+				overrides.clear();
+				forwarded.clear();
+
+				std::vector<const char*> arguments { };
+				arguments.reserve(tokens.size());
+
+				for (const auto& token : tokens)
+					arguments.push_back(token.c_str());
+
+				// Each option given (and the default command) receives its arguments in a copy
+				// owned by this layer, the parser's commands are left untouched.
+				const auto target = [this, &overrides](CmdBase* command) -> CmdBase* {
+					if (command->dominant)
+						return nullptr;
+
+					if (auto copy = _layer->override_of(command->name()))
+						return copy;
 
-	struct CallbackArgs
-	{
-		const std::vector<std::string>& arguments;
-		std::ostream& output;
-		std::ostream& error;
-	};
+					const auto copy = command->clone();
 
+					if (copy != nullptr)
+						overrides.emplace_back(copy);
 
-	template<typename T>
-	using ValidationFunction = std::function<bool(const T&, std::ostream&, std::ostream&)>;
+					return copy;
+				};
 
+				const auto scanned = _parser->scan(arguments.data(), arguments.size(), target, [&forwarded](const char* argument) { forwarded.emplace_back(argument); }, output, error);
 
-	class Parser
-	{
-	private:
-		class CmdBase
-		{
-		public:
-			explicit CmdBase(const std::string& name, const std::string& alternative, const std::string& description, bool required, bool dominant, bool variadic)
-				:	name(name),
-					command(name.size() > 0 ? "-" + name : ""),
-					alternative(alternative.size() > 0 ? "--" + alternative : ""),
-					description(description),
-					required(required),
-					handled(false),
-					arguments({}),
-					dominant(dominant),
-					variadic(variadic)
+				// The copy of the default command is only kept if it received a value.
+				overrides.erase(std::remove_if(overrides.begin(), overrides.end(), [](const std::unique_ptr<CmdBase>& command) { return !command->handled; }), overrides.end());
+
+				if (!scanned)
+					return false;
+
+				// The copies are fresh, hence there is nothing to reuse even in incremental mode.
+				for (const auto& command : overrides)
+				{
+					if (!_parser->parse_and_validate(command.get(), output, error))
+					{
+						error << "ERROR: The parameter '" << command->name() << "' has invalid arguments. Usage:\n";
+						error << command->usage();
+						return false;
+					}
+				}
+
+				return true;
+			}
+
+			/// The arguments of the last run left for someone else in forwarding mode.
+			const std::vector<std::string>& forwarded() const
 			{
+				return _layer->forwarded;
 			}
 
-			virtual ~CmdBase()
+			/// The value given to this overlay, or else the one of the layer below.
+			template<typename T>
+			T get(const std::string& name) const
 			{
+				for (const Layer* layer = _layer.get(); layer != nullptr; layer = layer->parent.get())
+				{
+					if (auto command = layer->override_of(name))
+						return _parser->value_of<T>(command);
+				}
+
+				return _parser->get<T>(name);
 			}
 
+			/// Another layer on top of this one.
+			Overlay overlay() const
+			{
+				return Overlay(*_parser, _layer);
+			}
 
-			virtual std::string print_value() const = 0;
-			virtual bool parse(std::ostream& output, std::ostream& error) = 0;
-			virtual bool validate(std::ostream& output, std::ostream& error) = 0;
-			virtual std::string	usage() const
+			/// Bytes used by this layer, i.e. by the options given to it.
+			size_t memory_usage() const
 			{
-				std::stringstream ss;
+				size_t bytes = sizeof(*this) + sizeof(Layer) + _layer->overrides.capacity() * sizeof(std::unique_ptr<CmdBase>);
 
-				if(command.empty() && alternative.empty())
-					ss << "\tDEFAULT" << std::endl;
-				else
-					ss << "\t" << command << ",\t" << alternative << std::endl;
+				// The labels are shared with the parser.
+				for (const auto& command : _layer->overrides)
+					bytes += command->memory_usage() - command->label_memory_usage();
 
-				if (required == true)
+				return bytes;
+			}
+
+		private:
+			friend class Parser;
+
+			/// The options given to an overlay. It is shared with the overlays on top of it.
+			struct Layer
+			{
+				explicit Layer(std::shared_ptr<const Layer> parent) : parent(std::move(parent))
 				{
-					ss << "\t\t(required)";
 				}
-				else
+
+				CmdBase* override_of(const std::string& name) const
 				{
-					ss << "\t\tDefault:\t'" + print_value() << "'" << std::endl;
-					ss << "\t\t[optional] ";
+					for (const auto& command : overrides)
+					{
+						if (name == command->name())
+							return command.get();
+					}
+
+					return nullptr;
 				}
 
-				ss << description << std::endl << std::endl;
+				std::shared_ptr<const Layer> parent;
+				std::vector<std::unique_ptr<CmdBase>> overrides;
+				std::vector<std::string> forwarded;
+			};
 
-				return ss.str();
+			Overlay(const Parser& parser, std::shared_ptr<const Layer> parent)
+				:	_parser(&parser)
+				,	_layer(std::make_shared<Layer>(std::move(parent)))
+			{
 			}
 
-			bool is(const std::string& given) const
+			const Parser* _parser;
+			std::shared_ptr<Layer> _layer;
+		};
+
+		/// A layer on top of the values of the last run, see Overlay.
+		Overlay overlay()
+		{
+			add_global_options();
+			return Overlay(*this, nullptr);
+		}
+
+		int requirements() const
+		{
+			int count = 0;
+
+			for (const auto& command : _commands)
 			{
-				return given == command || given == alternative;
+				if (command->required)
+				{
+					++count;
+				}
 			}
 
-		public:		
-			std::string 	name;
-			std::string 	command;
-			std::string 	alternative;
-			std::string 	description;
-			bool 			required;
-			bool 			handled;
-			bool const 		dominant;
-			bool const 		variadic;			
-			std::vector<std::string> arguments;
-		};
+			return count;
+		}
 
-		template<typename T>
-		struct ArgumentCountChecker
+		int commands() const
 		{
-			static constexpr bool Variadic = false;
-		};
+			return static_cast<int>(_commands.size());
+		}
 
-		template<typename T>
-		struct ArgumentCountChecker<cli::NumericalBase<T>>
+		/// Returns the number of bytes used by a single option, including its labels and value.
+		size_t memory_usage(const std::string& name) const
 		{
-			static constexpr bool Variadic = false;
-		};
+			const auto command = command_of(name);
+			return command->memory_usage() + state_memory_usage(command);
+		}
 
-		template<typename T>
-		struct ArgumentCountChecker<std::vector<T>>
+		/// Returns the number of bytes used by the parser and all of its options.
+		size_t memory_usage() const
 		{
-			static constexpr bool Variadic = true;
-		};
+			size_t bytes = sizeof(*this) + _pool.memory_usage() + heap_size(_appname) + heap_size(_general_help_text);
+			bytes += _commands.capacity() * sizeof(CmdBase*) + _index.capacity() * sizeof(NameEntry);
+			bytes += (_tokens.bucket_count() + _failures.bucket_count()) * sizeof(void*);
 
-		template<typename T>
-		class CmdFunction final : public CmdBase {
-		public:
-			explicit CmdFunction(const std::string& name, const std::string& alternative, const std::string& description, bool required, bool dominant)
-				:	CmdBase(name, alternative, description, required, dominant, ArgumentCountChecker<T>::Variadic)
+			for (const auto command : _commands)
 			{
+				// The labels are already accounted for by the pool.
+				bytes += command->memory_usage() - command->label_memory_usage() + state_memory_usage(command);
 			}
 
-			virtual bool parse(std::ostream& output, std::ostream& error)
-			{
-				try
-				{
-					CallbackArgs args { arguments, output, error };
-					value = callback(args);
-					return true;
-				}
-				catch(const std::exception& e)
-				{
-					error << "ERROR: Failed parsing function's arguments: " << std::endl;
-					
-					for(const auto& a : arguments)
-						error << a << ", " << std::endl;
+			return bytes;
+		}
 
-					error << e.what() << std::endl;
-					// error << Parser::print_help();
+		inline const std::string& app_name() const
+		{
+			return _appname;
+		}
 
-					return false;
-				}
-			}
+	protected:
+		/// Bytes used by the entries of the given command in the tables of the incremental and
+		/// the lazy mode.
+		size_t state_memory_usage(const CmdBase* command) const
+		{
+			size_t bytes = 0;
+			const auto tokens = _tokens.find(command);
+			const auto failure = _failures.find(command);
 
-			virtual bool validate(std::ostream& output, std::ostream& error) override
+			if (tokens != _tokens.end())
+				bytes += sizeof(*tokens) + heap_size(tokens->second);
+
+			if (failure != _failures.end())
+				bytes += sizeof(*failure) + heap_size(failure->second);
+
+			return bytes;
+		}
+
+		CmdBase* command_of(const std::string& name) const
+		{
+			for (const auto command : _commands)
 			{
-				return true;
+				if (name == command->name())
+					return command;
 			}
 
-			virtual std::string print_value() const
+			throw std::runtime_error("The parameter " + name + " could not be found.");
+		}
+
+		/// Runs the task for all indices in [0, count) on up to the given number of threads.
+		static void parallel_for(size_t count, unsigned int threads, const std::function<void(size_t)>& task)
+		{
+			std::atomic<size_t> next(0);
+			std::vector<std::thread> workers { };
+			const auto work = [&]() {
+				for (size_t i = next++; i < count; i = next++)
+					task(i);
+			};
+
+			for (size_t i = 1; i < std::min<size_t>(threads, count); ++i)
+				workers.emplace_back(work);
+
+			work();
+
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		/// Parses and validates the remaining options. Independent options, including their
+		/// callbacks, are handled concurrently before all others. The diagnostics are written
+		/// in declaration order regardless of the scheduling.
+		bool parse_in_parallel(std::ostream& output, std::ostream& error)
+		{
+			struct Validation
 			{
-				return "";
-			}
+				std::stringstream output;
+				std::stringstream error;
+				bool valid;
+			};
 
-			std::function<T(CallbackArgs&)> callback;
-			T value;
-		};
+			std::vector<CmdBase*> independent { };
 
-		template<typename T>
-		class CmdArgument final : public CmdBase {
-		public:
-			explicit CmdArgument(const std::string& name, const std::string& alternative, const std::string& description, bool required, bool dominant, ValidationFunction<T> vf = nullptr)
-				:	CmdBase(name, alternative, description, required, dominant, ArgumentCountChecker<T>::Variadic)
-				,	valFun(vf)
+			for (auto command : _commands)
 			{
+				if (command->handled && !command->dominant && command->independent)
+					independent.push_back(command);
 			}
 
-			virtual bool parse(std::ostream& output, std::ostream& error)
-			{
-				T result;
+			std::vector<Validation> validations(independent.size());
+
+			parallel_for(independent.size(), _threads, [&](size_t i) {
+				auto& validation = validations[i];
+
 				try
 				{
-					// Use default
-					if(!required && arguments.empty())
-						return true;
-
-					value = Parser::parse(arguments, value);
-					return true;
+					validation.valid = process(independent[i], validation.output, validation.error);
 				}
 				catch(const std::exception& e)
 				{
-					if(name.empty())
-						error << "ERROR: Parsing 'default' command arguments: ";
-					else
-						error << "ERROR: Parsing '" << name << "' command arguments: ";
+					validation.error << e.what() << std::endl;
+					validation.valid = false;
+				}
+			});
 
-					if(arguments.empty())
-					{
-						error << "no arguments provided";
-					}
-					else
-					{
-						for(const auto& a : arguments)
-							error << a << ", " << std::endl;
-					}
+			auto validation = validations.begin();
 
-					error << e.what() << std::endl;					
+			for (auto command : _commands)
+			{
+				if (!command->handled || command->dominant)
+					continue;
+
+				auto valid = true;
 
+				if (command->independent)
+				{
+					output << validation->output.str();
+					error << validation->error.str();
+					valid = (validation++)->valid;
+				}
+				else
+				{
+					valid = process(command, output, error);
+				}
+
+				if (!valid)
+				{
+					error << "ERROR: The parameter '" << command->name() << "' has invalid arguments. Usage:\n";
+					error << command->usage();
 					return false;
 				}
 			}
 
-			virtual bool validate(std::ostream& output, std::ostream& error) override
-			{
-				if(valFun != nullptr)
-					return valFun(value, output, error);
+			return true;
+		}
 
-				return true;
-			}
+		/// Assigns the arguments to the options they belong to. target maps an option (or the
+		/// default command) to the command taking its arguments, which is the option itself
+		/// unless an overlay is run, and collect receives the arguments left for someone else
+		/// in forwarding mode. A terminating option is parsed right away and ends the run.
+		template<typename Target, typename Collect>
+		bool scan(const char* const* arguments, size_t count, Target target, Collect collect, std::ostream& output, std::ostream& error) const
+		{
+			const auto fallback = [&]() -> CmdBase* {
+				const auto command = find_default();
+				return command != nullptr ? target(command) : nullptr;
+			};
 
-			virtual std::string print_value() const
+			auto current = fallback();
+			auto options = true;
+			auto forwarding = false;
+
+			for (size_t i = 0, n = count; i < n; ++i)
 			{
-				return stringify(value);
-			}
+				std::string currArg(arguments[i]);
 
-			T value;
-			ValidationFunction<T> valFun = nullptr;
-		};
+				// Everything after "--" is not an option.
+				if (options && currArg == "--")
+				{
+					options = false;
 
+					if (_forwarding)
+					{
+						for (++i; i < n; ++i)
+							collect(arguments[i]);
 
+						break;
+					}
 
-		static int parse(const std::vector<std::string>& elements, const int&, int numberBase = 0)
-		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+					continue;
+				}
 
-			return std::stoi(elements[0], 0, numberBase);
-		}
+				auto isarg = options && currArg.size() > 0 && currArg[0] == '-';
+				const auto option = isarg ? find(currArg) : nullptr;
+				const auto associated = option != nullptr ? target(option) : nullptr;
 
-		static bool parse(const std::vector<std::string>& elements, const bool& defval)
-		{
-			if (elements.size() != 0)
-				throw std::runtime_error("A boolean command line parameter cannot have any arguments.");
+				if (option != nullptr && associated == nullptr)
+				{
+					error << "ERROR: The parameter '" << option->name() << "' cannot be overridden." << std::endl;
+					return false;
+				}
 
-			return !defval;
-		}
+				// Unknown options, and the values following them, are left for someone else. A
+				// value the option before still expects, e.g. a negative number, is kept.
+				const auto expected = current != nullptr && !current->variadic && !current->flag && current->arguments.empty() && !is_default(current);
 
-		static double parse(const std::vector<std::string>& elements, const double&)
-		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+				if (_forwarding && associated == nullptr && !expected && (isarg ? abbreviations(currArg).size() < 2 : forwarding || current == nullptr))
+				{
+					collect(arguments[i]);
+					forwarding = true;
+					continue;
+				}
 
-			return std::stod(elements[0]);
-		}
+				forwarding = forwarding && associated == nullptr;
+
+				if (associated != nullptr && associated->terminating)
+				{
+					// Nothing else matters, so neither look at the remaining
+					// arguments nor convert any of the other options.
+					associated->handled = true;
+					associated->reusable = false;
+
+					if (!associated->parse(output, error) || !associated->validate(output, error))
+					{
+						error << "ERROR: The parameter '" << associated->name() << "' has invalid arguments. Usage:\n";
+						error << associated->usage();
+					}
+
+					return false;
+				}
+				else if (associated != nullptr)
+				{
+					current = associated;
+					associated->handled = true;
+				}
+				else if (current == nullptr || (isarg && abbreviations(currArg).size() > 1))
+				{
+					error << invalid_parameter(currArg);
+					// error << no_default();
+					return false;
+				}
+				else
+				{
+					if(!current->variadic)
+					{
+						if(current->arguments.empty())
+						{
+							current->arguments.push_back(std::move(currArg));
+							current->handled = true;
+						}
+						else if(isarg)
+						{
+							error << invalid_parameter(currArg);
+							return false;
+						}
+						else
+						{
+							if(is_default(current))
+								error << "'Default' command can have only one parameter." << std::endl;
+							else
+								error << "Command '" << current->name() << "[" << current->alternative << "]'" << " can have only one parameter." << std::endl;
+
+							error  << "Given parameter '" << currArg << "' is invalid in this context!" << std::endl;
+							output << print_help();
+
+							return false;
+						}
+
+						// If the current command is not variadic, then no more arguments
+						// should be added to it. In this case, switch back to the default
+						// command.
+						current = fallback();
+					}
+					else
+					{
+						current->handled = true;
 
-		static float parse(const std::vector<std::string>& elements, const float&)
-		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+						if (!current->accept(std::move(currArg), output, error))
+						{
+							error << "ERROR: The parameter '" << current->name() << "' has invalid arguments. Usage:\n";
+							error << current->usage();
+							return false;
+						}
+					}
+				}
+			}
 
-			return std::stof(elements[0]);
+			return true;
 		}
 
-		static long double parse(const std::vector<std::string>& elements, const long double&)
+		/// Parses and validates a command. In incremental mode the value is kept if the arguments
+		/// did not change since it has been converted.
+		bool process(CmdBase* command, std::ostream& output, std::ostream& error) const
 		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+			if (!_incremental)
+				return parse_and_validate(command, output, error);
 
-			return std::stold(elements[0]);
-		}
+			// The entry has been added by run, only looking it up is safe on several threads.
+			auto& tokens = _tokens.find(command)->second;
 
-		static unsigned int parse(const std::vector<std::string>& elements, const unsigned int&, int numberBase = 0)
-		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+			if (command->reusable && tokens == command->arguments)
+				return true;
 
-			return static_cast<unsigned int>(std::stoul(elements[0], 0, numberBase));
-		}
+			// Changed arguments are parsed from the default, not from the value of the last run
+			// (a flag would toggle back), and a value that failed is not kept for the next one.
+			command->reusable = false;
+			tokens = command->arguments;
+			command->restore();
+			command->reusable = parse_and_validate(command, output, error);
 
-		static unsigned long parse(const std::vector<std::string>& elements, const unsigned long&, int numberBase = 0)
-		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+			if (!command->reusable)
+				command->restore();
 
-			return std::stoul(elements[0], 0, numberBase);
+			return command->reusable;
 		}
 
-		static unsigned long long parse(const std::vector<std::string>& elements, const unsigned long long&, int numberBase = 0)
+		/// Parses and validates a command. The results of pure validators are taken from the
+		/// validation cache, if enabled, keyed by the command and its arguments. Commands are
+		/// identified by their labels interned in the parser's pool, which overlay clones share.
+		bool parse_and_validate(CmdBase* command, std::ostream& output, std::ostream& error) const
 		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+			if (!_validation_cache || !command->pure)
+				return command->parse(output, error) && command->validate(output, error) && command->publish();
 
-			return std::stoull(elements[0], 0, numberBase);
-		}
+			std::string key(reinterpret_cast<const char*>(&command->command), sizeof(command->command));
+			key.append(reinterpret_cast<const char*>(&command->alternative), sizeof(command->alternative));
 
-		static long long parse(const std::vector<std::string>& elements, const long long&, int numberBase = 0)
-		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
+			for (const auto& argument : command->arguments)
+			{
+				const auto size = argument.size();
+				key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+				key.append(argument);
+			}
 
-			return std::stoll(elements[0], 0, numberBase);
+			return command->parse(output, error) && _validation_cache->validate(key, command, output, error) && command->publish();
 		}
 
-		static long parse(const std::vector<std::string>& elements, const long&, int numberBase = 0)
+		void forward(const char* argument)
 		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
-
-			return std::stol(elements[0], 0, numberBase);
+			_forwarded.back() = argument;
+			_forwarded.push_back(nullptr);
 		}
 
-		static std::string parse(const std::vector<std::string>& elements, const std::string&)
+		static unsigned int first_bit(unsigned int mask)
 		{
-			if (elements.size() != 1)
-				throw std::bad_cast();
-
-			return elements[0];
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+#else
+			return __builtin_ctz(mask);
+#endif
 		}
 
-		template<class T>
-		static std::vector<T> parse(const std::vector<std::string>& elements, const std::vector<T>&)
+		/// Returns the first character in [begin, end) with a special meaning in the given quoting
+		/// state: blanks, quotes and backslashes outside of quotes, the closing quote within single
+		/// quotes and the closing quote or a backslash within double quotes.
+		static const char* find_special(const char* begin, const char* end, char quote)
 		{
-			const T defval = T();
-			std::vector<T> values { };
-			std::vector<std::string> buffer(1);
+#if defined(__AVX2__)
+			while (end - begin >= 32)
+			{
+				const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+				const auto is = [&chunk](char c) { return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c)); };
+				const __m256i hits = quote == 0
+					?	_mm256_or_si256(_mm256_or_si256(_mm256_or_si256(is(' '), is('\t')), _mm256_or_si256(is('\n'), is('\\'))), _mm256_or_si256(is('\''), is('"')))
+					:	quote == '"' ? _mm256_or_si256(is('"'), is('\\')) : is('\'');
+				const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(hits));
 
-			for (const auto& element : elements)
+				if (mask != 0)
+					return begin + first_bit(mask);
+
+				begin += 32;
+			}
+#elif defined(__SSE2__) || defined(_M_X64)
+			while (end - begin >= 16)
 			{
-				buffer[0] = element;
-				values.push_back(parse(buffer, defval));
+				const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+				const auto is = [&chunk](char c) { return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c)); };
+				const __m128i hits = quote == 0
+					?	_mm_or_si128(_mm_or_si128(_mm_or_si128(is(' '), is('\t')), _mm_or_si128(is('\n'), is('\\'))), _mm_or_si128(is('\''), is('"')))
+					:	quote == '"' ? _mm_or_si128(is('"'), is('\\')) : is('\'');
+				const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(hits));
+
+				if (mask != 0)
+					return begin + first_bit(mask);
+
+				begin += 16;
 			}
+#endif
+			for (; begin != end; ++begin)
+			{
+				const char c = *begin;
 
-			return values;
-		}
+				if (quote == 0 ? (c == ' ' || c == '\t' || c == '\n' || c == '\\' || c == '\'' || c == '"') : (c == quote || (quote == '"' && c == '\\')))
+					break;
+			}
 
-		template <typename T> static T parse(const std::vector<std::string>& elements, const NumericalBase<T>& wrapper)
-		{
-			return parse(elements, wrapper.value, 0);
+			return begin;
 		}
 
-		/// Specialization for number wrapped into numerical base
-		/// \tparam T base type of the argument
-		/// \tparam base numerical base
-		/// \param elements
-		/// \param wrapper
-		/// \return parsed number
-		template <typename T, int base> static T parse(const std::vector<std::string>& elements, const NumericalBase<T, base>& wrapper)
+		/// Splits a command line into the parser's own argument storage. A line that cannot be
+		/// split leaves the arguments of the previous run untouched.
+		bool tokenize(const std::string& line, std::ostream& error)
 		{
-			return parse(elements, wrapper.value, wrapper.base);
-		}
+			std::string buffer { };
+			std::vector<size_t> offsets { };
 
-		template<class T>
-		static std::string stringify(const T& value)
-		{
-			return std::to_string(value);
-		}
+			if (!split(line, buffer, offsets, error))
+				return false;
 
-		template<class T, int base>
-		static std::string stringify(const NumericalBase<T, base>& wrapper)
-		{
-			return std::to_string(wrapper.value);
+			adopt(buffer, offsets);
+			return true;
 		}
 
-		template<class T>
-		static std::string stringify(const std::vector<T>& values)
+		/// Copies the arguments into the parser's own storage.
+		void assign(const char* const* arguments, size_t count)
 		{
-			std::stringstream ss { };
-			ss << "[ ";
+			std::string buffer { };
+			std::vector<size_t> offsets { };
 
-			for (const auto& value : values)
+			for (size_t i = 0; i < count; ++i)
 			{
-				ss << stringify(value) << " ";
+				offsets.push_back(buffer.size());
+				buffer.append(arguments[i]);
+				buffer += '\0';
 			}
 
-			ss << "]";
-			return ss.str();
+			adopt(buffer, offsets);
 		}
 
-		static std::string stringify(const std::string& str)
+		/// Makes the null terminated tokens in buffer, starting at the offsets, the arguments
+		/// of the next run. The parser takes over the buffer.
+		void adopt(std::string& buffer, const std::vector<size_t>& offsets)
 		{
-			return str;
-		}
+			_storage.swap(buffer);
 
-	public:
-		explicit Parser(int argc, const char** argv)
-		{
-			init(argc, argv);
-		}
+			_storage_arguments.clear();
 
-		explicit Parser(int argc, char** argv)
-		{
-			init(argc, argv);
-		}
+			for (const auto offset : offsets)
+				_storage_arguments.push_back(_storage.data() + offset);
 
-		
-		Parser(int argc, const char** argv, std::string generalProgramDescriptionForHelpText)
-			:	_general_help_text(std::move(generalProgramDescriptionForHelpText))
-		{
-			init(argc, argv);
+			point(_storage_arguments.data(), _storage_arguments.size());
 		}
 
-		Parser(int argc, char** argv, std::string generalProgramDescriptionForHelpText)
-			:	_general_help_text(std::move(generalProgramDescriptionForHelpText))
+		/// Makes the given arguments those of the next run without copying them.
+		void point(const char* const* arguments, size_t count)
 		{
-			init(argc, argv);
+			_arguments = arguments;
+			_argument_count = count;
+			_forwarded.assign(2, nullptr);
+			index_presence();
 		}
 
-		
-		Parser()
-		{			
-		}
-		
-		Parser(std::string generalProgramDescriptionForHelpText)
-			:	_general_help_text(std::move(generalProgramDescriptionForHelpText))
-		{			
-		}
-		
-		
-		~Parser()
+		/// Hashes the arguments into the presence index. It is built right away, such that
+		/// is_present only reads and can be called from several threads.
+		void index_presence()
 		{
-			for (size_t i = 0, n = _commands.size(); i < n; ++i)
+			size_t size = 4;
+
+			while (size < _argument_count * 2)
+				size <<= 1;
+
+			_presence.assign(size, 0);
+			const size_t mask = _presence.size() - 1;
+
+			for (size_t i = 0; i < _argument_count; ++i)
 			{
-				delete _commands[i];
+				const auto argument = _arguments[i];
+				size_t slot = hash(argument, std::strlen(argument)) & mask;
+
+				while (_presence[slot] != 0 && std::strcmp(_arguments[_presence[slot] - 1], argument) != 0)
+					slot = (slot + 1) & mask;
+
+				_presence[slot] = i + 1;
 			}
 		}
-		
-		
-		void init(int argc, char** argv)
+
+		/// Splits the line into null terminated tokens stored in buffer, starting at the offsets.
+		static bool split(const std::string& line, std::string& buffer, std::vector<size_t>& offsets, std::ostream& error)
 		{
-			_appname = argv[0];
-			
-			for (int i = 1; i < argc; ++i)
+			auto current = line.data();
+			const auto end = current + line.size();
+			bool token = false;
+			char quote = 0;
+
+			buffer.clear();
+			buffer.reserve(line.size() + 1);
+
+			while (true)
 			{
-				_arguments.push_back(argv[i]);
+				const auto special = find_special(current, end, quote);
+
+				if (special != current)
+				{
+					if (!token)
+						offsets.push_back(buffer.size());
+
+					token = true;
+					buffer.append(current, special);
+				}
+
+				if (special == end)
+					break;
+
+				const char c = *special;
+				current = special + 1;
+
+				if (quote != 0 && c == quote)
+				{
+					quote = 0;
+				}
+				else if (c == '\\')
+				{
+					if (current == end)
+					{
+						error << "ERROR: The command line ends with an escape character." << std::endl;
+						return false;
+					}
+
+					// An escaped newline joins two lines. Within double quotes a backslash
+					// only escapes characters that would be special otherwise.
+					if (*current == '\n')
+					{
+						++current;
+						continue;
+					}
+
+					if (!token)
+						offsets.push_back(buffer.size());
+
+					token = true;
+
+					if (quote == 0 || *current == '"' || *current == '\\' || *current == '$' || *current == '`')
+						buffer += *current++;
+					else
+						buffer += c;
+				}
+				else if (c == '\'' || c == '"')
+				{
+					if (!token)
+						offsets.push_back(buffer.size());
+
+					token = true;
+					quote = c;
+				}
+				else if (token)
+				{
+					buffer += '\0';
+					token = false;
+				}
 			}
-			enable_help();
-		}
-		
-		void init(int argc, const char** argv)
-		{
-			_appname = argv[0];
-			
-			for (int i = 1; i < argc; ++i)
+
+			if (quote != 0)
 			{
-				_arguments.push_back(argv[i]);
+				error << "ERROR: The command line contains an unterminated quote." << std::endl;
+				return false;
 			}
-			enable_help();
+
+			if (token)
+				buffer += '\0';
+
+			return true;
 		}
 
-		
-		bool has_help() const
+		/// Looks up prefix + name in the presence index of the arguments.
+		bool is_present(const char* prefix, const std::string& name) const
 		{
-			for (const auto& command : _commands)
+			const size_t length = std::strlen(prefix);
+
+			if (_argument_count == 0 || length + name.size() == 0)
+				return false;
+
+			const size_t mask = _presence.size() - 1;
+			size_t slot = hash(name.data(), name.size(), hash(prefix, length)) & mask;
+
+			for (; _presence[slot] != 0; slot = (slot + 1) & mask)
 			{
-				if (command->name == "h" && command->alternative == "--help")
+				const auto argument = _arguments[_presence[slot] - 1];
+
+				if (std::strncmp(argument, prefix, length) == 0 && name == argument + length)
 					return true;
 			}
 
 			return false;
 		}
 
-		void enable_help()
+		template<typename T>
+		T& value_of(const std::string& name) const
 		{
-			set_callback(
-				"h",
-				"help",
-				std::function<bool(CallbackArgs&)>
-				(
-					[this](CallbackArgs& args)
-					{
-						args.output << this->usage();
-						// #pragma warning(push)
-						// #pragma warning(disable: 4702)
-						// exit(0);
-						return false;
-						// #pragma warning(pop)
-					}
-				),
-				"",
-				true
-			);
+			return value_of<T>(command_of(name));
 		}
 
-		void disable_help()
+		template<typename T>
+		T& value_of(CmdBase* command) const
 		{
-			for (auto command = _commands.begin(); command != _commands.end(); ++command)
+			if (auto cmd = dynamic_cast<CmdArgument<T>*>(command))
 			{
-				if ((*command)->name == "h" && (*command)->alternative == "--help")
-				{
-					_commands.erase(command);
-					delete *command;
-					break;
-				}
+				resolve(cmd);
+				return cmd->value;
 			}
-		}
 
-		template<typename T>
-		void set_default(bool is_required, const std::string& description = "", T defaultValue = T(), ValidationFunction<T> vf = nullptr)
-		{
-			auto command = new CmdArgument<T> { "", "", description, is_required, false, vf };
-			command->value = defaultValue;
-			_commands.push_back(command);
-		}
+			if (auto cmd = dynamic_cast<CmdFunction<T>*>(command))
+			{
+				resolve(cmd);
+				return cmd->value;
+			}
 
-		template<typename T>
-		void set_required(const std::string& name, const std::string& alternative, const std::string& description = "", ValidationFunction<T> vf = nullptr, bool dominant = false)
-		{
-			auto command = new CmdArgument<T> { name, alternative, description, true, dominant, vf };
-			_commands.push_back(command);
+			if (auto cmd = dynamic_cast<CmdGlobal<T>*>(command))
+				return *cmd->storage;
+
+			if (dynamic_cast<CmdLive<T>*>(command))
+				throw std::runtime_error("The value of the live parameter " + std::string(command->name()) + " can only be copied, e.g. by get.");
+
+			throw std::runtime_error("Invalid usage of the parameter " + std::string(command->name()) + " detected.");
 		}
 
-		template<typename T>
-		void set_optional(const std::string& name, const std::string& alternative, T defaultValue, const std::string& description = "", ValidationFunction<T> vf = nullptr, bool dominant = false)
+		/// Converts and validates an option whose parsing has been deferred by the lazy mode.
+		/// This is why get is const but still changes the (deferred) state of the commands.
+		/// A failure is kept and thrown again by every later call until the next run.
+		void resolve(CmdBase* command) const
 		{
-			auto command = new CmdArgument<T> { name, alternative, description, false, dominant, vf };
-			command->value = defaultValue;
-			_commands.push_back(command);
+			std::string failure { };
+
+			if (!settle(command, &failure))
+				throw std::runtime_error(failure);
 		}
 
-		template<typename T>
-		void set_callback(const std::string& name, const std::string& alternative, std::function<T(CallbackArgs&)> callback, const std::string& description = "", bool dominant = false)
+		/// Like resolve, but returns false instead of throwing if the conversion failed. The
+		/// deferred state is only touched under the lock, such that get may be called from
+		/// several threads; it is recursive since deferred callbacks may call get themselves.
+		bool settle(CmdBase* command, std::string* failure = nullptr) const
 		{
-			auto command = new CmdFunction<T> { name, alternative, description, false, dominant };
-			command->callback = callback;
-			_commands.push_back(command);
+			std::lock_guard<std::recursive_mutex> lock(_resolving);
+
+			if (command->pending)
+			{
+				std::stringstream output { };
+				std::stringstream error { };
+				command->pending = false;
+
+				if (!process(command, output, error))
+				{
+					error << "ERROR: The parameter '" << command->name() << "' has invalid arguments. Usage:\n";
+					error << command->usage();
+					_failures[command] = error.str();
+				}
+			}
+
+			const auto found = _failures.find(command);
+
+			if (found == _failures.end())
+				return true;
+
+			if (failure != nullptr)
+				*failure = found->second;
+
+			return false;
 		}
 
-		inline void run_and_exit_if_error()
+		void add_global_options()
 		{
-			if (run() == false)
+			if (!_globals || _globals_added)
+				return;
+
+			_globals_added = true;
+
+			std::vector<GlobalOptions> modules(1, CMDPARSER_GLOBAL_OPTIONS);
+			modules.insert(modules.end(), _global_libraries.begin(), _global_libraries.end());
+
+			// A library may be linked statically as well, or share the registrations of the
+			// program where there are no linker sections.
+			const auto add = [this](const GlobalOption* option) {
+				if (std::find(_global_options.begin(), _global_options.end(), option) != _global_options.end())
+					return;
+
+				_global_options.push_back(option);
+				option->add(*this, *option);
+			};
+
+			for (const auto& module : modules)
 			{
-				exit(1);
+#if defined(__ELF__)
+				for (auto option = module.begin; option != module.end; ++option)
+					add(option);
+#else
+				for (auto registration = module.first; registration != nullptr; registration = registration->next)
+					add(registration->option);
+#endif
 			}
 		}
 
-		inline bool run()
+		/// The text written to an error stream, without the final line break.
+		static std::string message(const std::stringstream& error)
 		{
-			return run(std::cout, std::cerr);
-		}
+			auto text = error.str();
 
-		inline bool run(std::ostream& output)
-		{
-			return run(output, std::cerr);
+			while (!text.empty() && text.back() == '\n')
+				text.pop_back();
+
+			return text;
 		}
 
-		bool doesArgumentExist(std::string name, std::string altName)
+		/// Answers a request of the admin socket.
+		std::string administer(std::string request)
 		{
-			for (const auto& argument : _arguments)
+			std::stringstream output { };
+			std::stringstream error { };
+			auto valid = true;
+
+			if (!request.empty() && request.back() == '\r')
+				request.pop_back();
+
+			if (request == "list")
 			{
-				
-				if(argument == '-'+ name || argument == altName)
+				std::lock_guard<std::mutex> lock(_updates);
+
+				for (auto command : _commands)
 				{
-					return true;
+					if (command->runtime)
+						output << command->name() << ' ' << command->print_value() << '\n';
 				}
 			}
+			else if (request.compare(0, 4, "set ") == 0)
+			{
+				const auto separator = request.find(' ', 4);
+				const auto name = request.substr(4, separator == std::string::npos ? std::string::npos : separator - 4);
+				valid = update(name, separator == std::string::npos ? "" : request.substr(separator + 1), output, error);
+			}
+			else
+			{
+				error << "ERROR: Unknown request '" << request << "'." << std::endl;
+				valid = false;
+			}
 
-			return false;
+			return output.str() + error.str() + (valid ? "OK\n" : "ERROR\n");
 		}
 
-		inline bool doesHelpExist()
+#if defined(__linux__)
+		/// A thread passing the events epoll waits for to a handler, until it is stopped or
+		/// destroyed. The admin socket and the configuration watcher each run on one.
+		class EventLoop
 		{
-			return doesArgumentExist("h", "--help");
-		}
+		public:
+			using Handler = std::function<void(const epoll_event&)>;
 
-		bool run(std::ostream& output, std::ostream& error)
-		{
-			if (_arguments.size() > 0)
+			EventLoop()
+				:	_epoll(epoll_create1(EPOLL_CLOEXEC))
+				,	_stop(eventfd(0, EFD_CLOEXEC))
+			{}
+
+			EventLoop(const EventLoop&) = delete;
+			EventLoop& operator=(const EventLoop&) = delete;
+
+			~EventLoop()
 			{
-				auto current = find_default();
+				stop();
 
-				for (size_t i = 0, n = _arguments.size(); i < n; ++i)
+				for (const auto fd : { _epoll, _stop })
 				{
-					const auto& currArg = _arguments[i];
-					auto isarg = currArg.size() > 0 && currArg[0] == '-';
-					auto associated = isarg ? find(currArg) : nullptr;
+					if (fd >= 0)
+						::close(fd);
+				}
+			}
 
-					if (associated != nullptr)
-					{
-						current = associated;
-						associated->handled = true;
-					}
-					else if (current == nullptr)
-					{
-						error << invalid_parameter(currArg);
-						// error << no_default();
-						return false;
-					}
-					else
-					{
-						if(!current->variadic)
-						{
-							if(current->arguments.empty())
-								current->arguments.push_back(currArg);
-							else if(isarg)
-							{
-								error << invalid_parameter(currArg);
-								return false;
-							}
-							else
-							{
-								if(is_default(current))
-									error << "'Default' command can have only one parameter." << std::endl;
-								else
-									error << "Command '" << current->name << "[" << current->alternative << "]'" << " can have only one parameter." << std::endl;
+			/// Adds (or changes) the events waited for on the descriptor.
+			bool poll(int operation, int fd, uint32_t events)
+			{
+				epoll_event event { };
+				event.events = events;
+				event.data.fd = fd;
+				return _epoll >= 0 && epoll_ctl(_epoll, operation, fd, &event) == 0;
+			}
 
-								error  << "Given parameter '" << currArg << "' is invalid in this context!" << std::endl;
-								output << print_help();
+			void remove(int fd)
+			{
+				epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+			}
 
-								return false;
-							}
+			/// Starts the thread, which is only done once it can be stopped again.
+			bool start(Handler handler)
+			{
+				if (_stop < 0 || !poll(EPOLL_CTL_ADD, _stop, EPOLLIN))
+					return false;
 
-							// If the current command is not variadic, then no more arguments
-							// should be added to it. In this case, switch back to the default
-							// command.
-							current = find_default();
-						}
-						else
-							current->arguments.push_back(currArg);
+				_thread = std::thread([this, handler]() { run(handler); });
+				return true;
+			}
 
-						current->handled = true;
+			/// Wakes up the thread and waits until it ends, the handler is not called anymore.
+			void stop()
+			{
+				if (!_thread.joinable())
+					return;
+
+				const uint64_t value = 1;
+
+				while (::write(_stop, &value, sizeof(value)) < 0 && errno == EINTR)
+				{
+				}
+
+				_thread.join();
+			}
+
+		private:
+			void run(const Handler& handler)
+			{
+				epoll_event events[16];
+
+				for (;;)
+				{
+					const int count = epoll_wait(_epoll, events, 16, -1);
+
+					if (count < 0 && errno != EINTR)
+						return;
+
+					for (int i = 0; i < count; ++i)
+					{
+						if (events[i].data.fd == _stop)
+							return;
+
+						handler(events[i]);
 					}
 				}
 			}
 
-			// First, parse dominant arguments since they succeed even if required
-			// arguments are missing.
-			for (auto command : _commands)
+			int _epoll;
+			int _stop;
+			std::thread _thread;
+		};
+
+		/// Serves the admin socket, see start_admin_socket. Clients are never waited for:
+		/// responses that cannot be sent right away are buffered until the client is ready
+		/// again, and clients whose requests or responses pile up beyond a limit are dropped.
+		class AdminSocket
+		{
+		public:
+			/// Takes over the listening socket and removes the path when destroyed.
+			AdminSocket(Parser& parser, int listener, std::string path)
+				:	_parser(parser)
+				,	_listener(listener)
+				,	_path(std::move(path))
+			{}
+
+			~AdminSocket()
+			{
+				_loop.stop();
+
+				for (const auto& client : _clients)
+					::close(client.first);
+
+				::close(_listener);
+				::unlink(_path.c_str());
+			}
+
+			bool start()
+			{
+				return _loop.poll(EPOLL_CTL_ADD, _listener, EPOLLIN) && _loop.start([this](const epoll_event& event) { handle(event); });
+			}
+
+		private:
+			static const size_t Limit = 64 * 1024;
+
+			/// The requests received and the responses not sent yet.
+			struct Client
+			{
+				std::string input;
+				std::string output;
+				bool writing = false;
+			};
+
+			void handle(const epoll_event& event)
 			{
-				if (command->handled && command->dominant && ( !command->parse(output, error) || !command->validate(output, error)))
+				const int fd = event.data.fd;
+
+				if (fd == _listener)
 				{
-					error << "ERROR: The parameter '" << command->name << "' has invalid arguments. Usage:\n";
-					error << command->usage();
-					return false;
+					const int client = ::accept4(_listener, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+
+					if (client >= 0 && _loop.poll(EPOLL_CTL_ADD, client, EPOLLIN))
+						_clients[client];
+					else if (client >= 0)
+						::close(client);
+				}
+				else if (_clients.count(fd) != 0)
+				{
+					if (event.events & EPOLLOUT)
+						send(fd);
+
+					if (_clients.count(fd) != 0 && (event.events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+						receive(fd);
 				}
 			}
 
-			// Next, check for any missing arguments.
-			for (auto command : _commands)
+			void receive(int fd)
 			{
-				if (command->required && !command->handled)
+				char buffer[4096];
+				const auto size = ::read(fd, buffer, sizeof(buffer));
+
+				if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+					return;
+
+				if (size <= 0)
 				{
-					error << "ERROR: The parameter '" << command->name << "' is required. Usage:\n";
-					error << command->usage();
-					return false;
+					drop(fd);
+					return;
+				}
+
+				auto& client = _clients[fd];
+				client.input.append(buffer, static_cast<size_t>(size));
+
+				size_t begin = 0;
+
+				for (auto end = client.input.find('\n'); end != std::string::npos; end = client.input.find('\n', begin))
+				{
+					client.output += _parser.administer(client.input.substr(begin, end - begin));
+					begin = end + 1;
+				}
+
+				client.input.erase(0, begin);
+
+				if (client.input.size() > Limit || client.output.size() > Limit)
+				{
+					drop(fd);
+					return;
 				}
+
+				send(fd);
 			}
 
-			// Finally, parse all remaining arguments.
-			for (auto command : _commands)
+			/// Sends as much of the buffered responses as the client takes without blocking, and
+			/// waits until it is ready again for the rest.
+			void send(int fd)
 			{
-				if (command->handled && !command->dominant && ( !command->parse(output, error) || !command->validate(output, error) ) )
+				auto& client = _clients[fd];
+				auto& output = client.output;
+				size_t sent = 0;
+
+				while (sent < output.size())
 				{
-					error << "ERROR: The parameter '" << command->name << "' has invalid arguments. Usage:\n";
-					error << command->usage();
-					return false;
+					const auto result = ::send(fd, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+
+					if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+						break;
+
+					if (result < 0 && errno == EINTR)
+						continue;
+
+					if (result <= 0)
+					{
+						drop(fd);
+						return;
+					}
+
+					sent += static_cast<size_t>(result);
+				}
+
+				output.erase(0, sent);
+
+				if (client.writing != !output.empty())
+				{
+					client.writing = !output.empty();
+
+					if (!_loop.poll(EPOLL_CTL_MOD, fd, client.writing ? EPOLLIN | EPOLLOUT : EPOLLIN))
+						drop(fd);
 				}
 			}
 
-			return true;
-		}
+			void drop(int fd)
+			{
+				_loop.remove(fd);
+				::close(fd);
+				_clients.erase(fd);
+			}
 
-		template<typename T>
-		T get(const std::string& name) const
+			Parser& _parser;
+			int _listener;
+			std::string _path;
+			std::unordered_map<int, Client> _clients;
+			EventLoop _loop;
+		};
+
+		/// Reloads the configuration file, see watch_config.
+		class ConfigWatcher
 		{
-			for (const auto& command : _commands)
+		public:
+			/// Takes over the inotify descriptor watching the file's directory.
+			ConfigWatcher(Parser& parser, int inotify, std::string path, std::string file, ReloadFunction listener)
+				:	_parser(parser)
+				,	_inotify(inotify)
+				,	_path(std::move(path))
+				,	_file(std::move(file))
+				,	_listener(std::move(listener))
+			{}
+
+			~ConfigWatcher()
+			{
+				_loop.stop();
+				::close(_inotify);
+			}
+
+			bool start()
 			{
-				if (command->name == name)
+				return _loop.poll(EPOLL_CTL_ADD, _inotify, EPOLLIN) && _loop.start([this](const epoll_event&) { handle(); });
+			}
+
+		private:
+			void handle()
+			{
+				alignas(inotify_event) char buffer[4096];
+				const auto size = ::read(_inotify, buffer, sizeof(buffer));
+				auto changed = false;
+
+				for (ssize_t offset = 0; offset < size; )
 				{
-					auto cmd = dynamic_cast<CmdArgument<T>*>(command);
+					const auto change = reinterpret_cast<const inotify_event*>(buffer + offset);
+					changed = changed || (change->len > 0 && _file == change->name);
+					offset += sizeof(inotify_event) + change->len;
+				}
 
-					if (cmd == nullptr)
-					{
-						throw std::runtime_error("Invalid usage of the parameter " + name + " detected.");
-					}
+				if (changed)
+				{
+					const auto diagnostics = _parser.reload(_path);
 
-					return cmd->value;
+					if (_listener)
+						_listener(diagnostics);
 				}
 			}
 
-			throw std::runtime_error("The parameter " + name + " could not be found.");
+			Parser& _parser;
+			int _inotify;
+			std::string _path;
+			std::string _file;
+			ReloadFunction _listener;
+			EventLoop _loop;
+		};
+#endif
+
+		struct NameEntry
+		{
+			const char* name;
+			CmdBase* command;
+		};
+
+		void add_command(CmdBase* command)
+		{
+			command->use_conversion_cache(_conversions.get());
+			_commands.push_back(command);
+			_index.clear();
 		}
 
-		template<typename T>
-		T get_default()
+		/// Lazily built, lexicographically sorted list of all option names.
+		const std::vector<NameEntry>& name_index() const
 		{
-			return get<T>("");
+			if (_index.empty())
+			{
+				for (const auto command : _commands)
+				{
+					if (*command->command)
+						_index.push_back(NameEntry { command->command, command });
+
+					if (*command->alternative)
+						_index.push_back(NameEntry { command->alternative, command });
+				}
+
+				std::sort(_index.begin(), _index.end(), [](const NameEntry& a, const NameEntry& b) {
+					return std::strcmp(a.name, b.name) < 0;
+				});
+			}
+
+			return _index;
 		}
 
-		template<typename T>
-		T get_if(const std::string& name, std::function<T(T)> callback) const
+		typedef std::vector<NameEntry>::const_iterator NameIterator;
+
+		/// Returns the range of the name index starting with the given prefix.
+		std::pair<NameIterator, NameIterator> prefix_range(const std::string& prefix) const
 		{
-			auto value = get<T>(name);
-			return callback(value);
+			const auto& index = name_index();
+			auto first = std::lower_bound(index.begin(), index.end(), prefix, [](const NameEntry& entry, const std::string& key) {
+				return std::strcmp(entry.name, key.c_str()) < 0;
+			});
+			auto last = first;
+
+			while (last != index.end() && std::strncmp(last->name, prefix.c_str(), prefix.size()) == 0)
+				++last;
+
+			return std::make_pair(first, last);
 		}
 
-		int requirements() const
+		/// Returns the long options the given token is an abbreviation of.
+		std::vector<std::string> abbreviations(const std::string& token) const
 		{
-			int count = 0;
+			std::vector<std::string> candidates { };
 
-			for (const auto& command : _commands)
+			if (!_abbreviations || token.size() <= 2 || token.compare(0, 2, "--") != 0)
+				return candidates;
+
+			const auto range = prefix_range(token);
+
+			for (auto it = range.first; it != range.second; ++it)
 			{
-				if (command->required)
-				{
-					++count;
-				}
+				if (it->name == it->command->alternative)
+					candidates.push_back(it->name);
 			}
 
-			return count;
+			return candidates;
 		}
 
-		int commands() const
+		/// Restricted Damerau-Levenshtein distance between a pattern of at most 64 characters,
+		/// given by its match masks, and a text (Hyyrö's extension of Myers' bit-parallel algorithm).
+		/// Stops with limit + 1 as soon as the distance is known to exceed the limit.
+		static size_t edit_distance(const uint64_t (&peq)[256], size_t m, const char* text, size_t n, size_t limit)
 		{
-			return static_cast<int>(_commands.size());
+			if ((m > n ? m - n : n - m) > limit)
+				return limit + 1;
+
+			if (m == 0)
+				return n;
+
+			const uint64_t last = uint64_t(1) << (m - 1);
+			uint64_t vp = ~uint64_t(0);
+			uint64_t vn = 0;
+			uint64_t d0 = 0;
+			uint64_t previous = 0;
+			size_t score = m;
+
+			for (size_t j = 0; j < n; ++j)
+			{
+				const uint64_t pm = peq[static_cast<unsigned char>(text[j])];
+				const uint64_t tr = (((~d0) & pm) << 1) & previous;
+				d0 = (((pm & vp) + vp) ^ vp) | pm | vn | tr;
+
+				uint64_t hp = vn | ~(d0 | vp);
+				uint64_t hn = d0 & vp;
+
+				if (hp & last)
+					++score;
+				else if (hn & last)
+					--score;
+
+				// The score can drop by at most one per remaining character.
+				if (score > limit + (n - j - 1))
+					return limit + 1;
+
+				hp = (hp << 1) | 1;
+				hn = hn << 1;
+				vp = hn | ~(d0 | hp);
+				vn = d0 & hp;
+				previous = pm;
+			}
+
+			return score;
 		}
 
-		inline const std::string& app_name() const
+		/// Restricted Damerau-Levenshtein distance for patterns too long for the bit-parallel kernel.
+		static size_t edit_distance(const std::string& pattern, const char* text, size_t n, size_t limit)
 		{
-			return _appname;
+			const size_t m = pattern.size();
+
+			if ((m > n ? m - n : n - m) > limit)
+				return limit + 1;
+
+			std::vector<size_t> before(n + 1), previous(n + 1), current(n + 1);
+
+			for (size_t j = 0; j <= n; ++j)
+				previous[j] = j;
+
+			for (size_t i = 1; i <= m; ++i)
+			{
+				size_t best = current[0] = i;
+
+				for (size_t j = 1; j <= n; ++j)
+				{
+					const size_t cost = pattern[i - 1] == text[j - 1] ? 0 : 1;
+					current[j] = std::min(std::min(previous[j] + 1, current[j - 1] + 1), previous[j - 1] + cost);
+
+					if (i > 1 && j > 1 && pattern[i - 1] == text[j - 2] && pattern[i - 2] == text[j - 1])
+						current[j] = std::min(current[j], before[j - 2] + 1);
+
+					best = std::min(best, current[j]);
+				}
+
+				if (best > limit)
+					return limit + 1;
+
+				before.swap(previous);
+				previous.swap(current);
+			}
+
+			return previous[n];
 		}
 
-	protected:
-		CmdBase* find(const std::string& name)
+		/// Returns the registered option name closest to the given unknown parameter, or an
+		/// empty string if no name is close enough to be a plausible typo.
+		std::string suggest(const std::string& param) const
 		{
-			for (auto command : _commands)
+			const size_t limit = param.size() / 3;
+			const NameEntry* best = nullptr;
+			size_t distance = limit + 1;
+			uint64_t peq[256] = { };
+
+			if (limit == 0)
+				return "";
+
+			for (size_t i = 0; i < param.size() && i < 64; ++i)
+				peq[static_cast<unsigned char>(param[i])] |= uint64_t(1) << i;
+
+			for (const auto& entry : name_index())
 			{
-				if (command->is(name))
+				const auto d = param.size() <= 64
+					?	edit_distance(peq, param.size(), entry.name, std::strlen(entry.name), distance - 1)
+					:	edit_distance(param, entry.name, std::strlen(entry.name), distance - 1);
+
+				if (d < distance)
 				{
-					return command;
+					distance = d;
+					best = &entry;
 				}
 			}
 
+			return best != nullptr ? best->name : "";
+		}
+
+		CmdBase* find(const std::string& name) const
+		{
+			const auto range = prefix_range(name);
+
+			if (range.first != range.second && range.first->name == name)
+				return range.first->command;
+
+			const auto candidates = abbreviations(name);
+
+			if (candidates.size() == 1)
+				return prefix_range(candidates[0]).first->command;
+
 			return nullptr;
 		}
 
-		CmdBase* find_default()
+		CmdBase* find_default() const
 		{
 			for (auto command : _commands)
 			{
-				if (command->name == "")
+				if (!*command->command)
 				{
 					return command;
 				}
@@ -767,13 +4612,20 @@ namespace cli
 
 		bool is_default(const CmdBase* cmd) const
 		{
-			return cmd->command.empty() && cmd->alternative.empty();
+			return !*cmd->command && !*cmd->alternative;
+		}
+
+		static bool is_help(const CmdBase* cmd)
+		{
+			return std::strcmp(cmd->command, "-h") == 0 && std::strcmp(cmd->alternative, "--help") == 0;
 		}
 
 		std::string usage() const
 		{
 			std::stringstream ss { };
-			ss << _general_help_text << "\n\n";
+			if (!_general_help_text.empty())
+				ss << _general_help_text << "\n\n";
+
 			ss << "Available parameters:\n\n";
 
 			for (const auto& command : _commands)
@@ -784,6 +4636,43 @@ namespace cli
 			return ss.str();
 		}
 
+		/// Writes the static usage text, filling in runtime defaults marked by CMDPARSER_USAGE_RUNTIME.
+		void print_static_usage(std::ostream& output) const
+		{
+			assert(check_static_usage(std::cerr) && "The static usage text does not match the registered options");
+
+			const char marker = '\x1a';
+			auto current = _static_usage;
+			const auto end = _static_usage + _static_usage_size;
+
+			while (current != end)
+			{
+				auto begin = static_cast<const char*>(std::memchr(current, marker, end - current));
+				auto close = begin != nullptr ? static_cast<const char*>(std::memchr(begin + 1, marker, end - begin - 1)) : nullptr;
+
+				if (close == nullptr)
+				{
+					output.write(current, end - current);
+					break;
+				}
+
+				output.write(current, begin - current);
+
+				const std::string name(begin + 1, close);
+
+				for (const auto command : _commands)
+				{
+					if (name == command->name())
+					{
+						output << command->print_value();
+						break;
+					}
+				}
+
+				current = close + 1;
+			}
+		}
+
 		std::string print_help() const
 		{
 			if (has_help())
@@ -795,7 +4684,28 @@ namespace cli
 		std::string invalid_parameter(const std::string& param) const
 		{
 			std::stringstream ss { };
+			const auto candidates = abbreviations(param);
+
+			if (candidates.size() > 1)
+			{
+				ss << "ERROR: Ambiguous parameter '" << param << "', could be";
+
+				for (const auto& candidate : candidates)
+					ss << " '" << candidate << "'";
+
+				ss << "\n";
+				ss << print_help();
+
+				return ss.str();
+			}
+
 			ss << "ERROR: Invalid parameter '" << param << "'\n";
+
+			const auto suggestion = suggest(param);
+
+			if (!suggestion.empty())
+				ss << "Did you mean '" << suggestion << "'?\n";
+
 			ss << print_help();
 
 			return ss.str();
@@ -814,7 +4724,57 @@ namespace cli
 	private:
 		std::string _appname;
 		std::string _general_help_text;
-		std::vector<std::string> _arguments;
+		const char* const* _arguments = nullptr;
+		size_t _argument_count = 0;
+		std::vector<size_t> _presence;
+		std::vector<const char*> _forwarded = std::vector<const char*>(2, nullptr);
+		bool _forwarding = false;
+		std::string _storage;
+		std::vector<const char*> _storage_arguments;
 		std::vector<CmdBase*> _commands;
+		StringPool _pool;
+		mutable std::vector<NameEntry> _index;
+		bool _completion = false;
+		bool _abbreviations = false;
+		bool _lazy = false;
+		unsigned int _threads = 1;
+		std::unique_ptr<ValidationCache> _validation_cache;
+		std::unique_ptr<ConversionCounters> _conversions;
+		bool _incremental = false;
+		/// The arguments the current values have been converted from (incremental runs only).
+		mutable std::unordered_map<const CmdBase*, std::vector<std::string>> _tokens;
+		/// The diagnostics of deferred conversions that failed (lazy parsing only).
+		mutable std::unordered_map<const CmdBase*, std::string> _failures;
+		/// Guards the deferred state of the commands and _failures while get resolves them.
+		mutable std::recursive_mutex _resolving;
+		bool _globals = false;
+		bool _globals_added = false;
+		std::vector<GlobalOptions> _global_libraries;
+		/// The descriptors of the global options added already.
+		std::vector<const GlobalOption*> _global_options;
+		std::mutex _updates;
+		std::shared_ptr<LiveState> _live = std::make_shared<LiveState>();
+#if defined(__linux__)
+		std::unique_ptr<AdminSocket> _admin;
+		std::unique_ptr<ConfigWatcher> _watcher;
+#endif
+
+		enum : uint32_t
+		{
+			SnapshotMagic = 0x50444d43,
+			SnapshotVersion = 1,
+			SnapshotHandled = 1,
+			SnapshotStored = 2
+		};
+
+		const char* _static_usage = nullptr;
+		size_t _static_usage_size = 0;
 	};
+
+	/// Adds an option defined by CMDPARSER_GLOBAL to the parser.
+	template<typename T>
+	void add_global(Parser& parser, const GlobalOption& option)
+	{
+		parser.set_global<T>(option.name, option.alternative, static_cast<T*>(option.storage), option.description);
+	}
 }